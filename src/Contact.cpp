@@ -0,0 +1,106 @@
+#include "Contact.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+// +1 for counter-clockwise vertex order, -1 for clockwise
+static Real winding(const Vec2* x, int n) {
+    Real area = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const Vec2& a = x[i];
+        const Vec2& b = x[(i + 1) % n];
+        area += a.x() * b.y() - a.y() * b.x();
+    }
+    return area >= 0.0 ? 1.0 : -1.0;
+}
+
+static Vec2 outwardNormal(const Vec2* x, int n, int i, Real sign) {
+    Vec2 e = x[(i + 1) % n] - x[i];
+    return (sign * Vec2(e.y(), -e.x())).normalized();
+}
+
+// Edge whose outward normal is most aligned with dir
+static int mostAlignedEdge(const Vec2* x, int n, const Vec2& dir) {
+    Real sign = winding(x, n);
+    int best = 0;
+    Real bestDot = -numeric_limits<Real>::infinity();
+    for (int i = 0; i < n; ++i) {
+        Real d = outwardNormal(x, n, i, sign).dot(dir);
+        if (d > bestDot) {
+            bestDot = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool buildManifold(const Vec2* xr, int nr, const Vec2* xi, int ni, const Vec2& n, ContactManifold& m,
+    Real speculative) {
+    m.normal = n;
+    m.count = 0;
+    m.referenceEdge = mostAlignedEdge(xr, nr, n);
+    m.incidentEdge = mostAlignedEdge(xi, ni, -n);
+
+    const Vec2& v1 = xr[m.referenceEdge];
+    const Vec2& v2 = xr[(m.referenceEdge + 1) % nr];
+    const Vec2& p1 = xi[m.incidentEdge];
+    const Vec2& p2 = xi[(m.incidentEdge + 1) % ni];
+
+    // Clip the incident segment p(t) = p1 + t (p2 - p1) to the slab between
+    // the side planes through v1 and v2
+    Vec2 tangent = v2 - v1;
+    Real refLength = tangent.norm();
+    if (refLength < 1e-12) return false;
+    tangent /= refLength;
+
+    Real lo = 0.0, hi = 1.0;
+    auto clip = [&](Real f1, Real f2) {
+        // Keep the part of [lo, hi] where f(t) = f1 + t (f2 - f1) >= 0
+        if (f1 >= 0.0 && f2 >= 0.0) return;
+        if (f1 < 0.0 && f2 < 0.0) {
+            lo = 1.0;
+            hi = 0.0;
+            return;
+        }
+        Real t = f1 / (f1 - f2);
+        if (f1 < 0.0) lo = std::max(lo, t);
+        else hi = std::min(hi, t);
+        };
+
+    clip(tangent.dot(p1 - v1), tangent.dot(p2 - v1));
+    clip(tangent.dot(v2 - p1), tangent.dot(v2 - p2));
+    Real ts[2] = { lo, hi };
+    int candidates = lo > hi ? 0 : (hi - lo > 1e-9) ? 2 : 1;
+    for (int k = 0; k < candidates; ++k) {
+        Vec2 p = p1 + ts[k] * (p2 - p1);
+        Real separation = (p - v1).dot(n);
+        if (separation < speculative) {
+            m.incidentT[m.count] = ts[k];
+            m.separation[m.count] = separation;
+            ++m.count;
+        }
+    }
+
+    // Corner-on-corner contacts can clip away every point; fall back to the
+    // incident vertex that lies deepest behind the reference edge
+    if (m.count == 0) {
+        int deepest = 0;
+        Real minSeparation = numeric_limits<Real>::infinity();
+        for (int i = 0; i < ni; ++i) {
+            Real separation = (xi[i] - v1).dot(n);
+            if (separation < minSeparation) {
+                minSeparation = separation;
+                deepest = i;
+            }
+        }
+        if (minSeparation < speculative) {
+            m.incidentEdge = deepest;
+            m.incidentT[0] = 0.0;
+            m.separation[0] = minSeparation;
+            m.count = 1;
+        }
+    }
+    return m.count > 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef CONTACT_H
+#define CONTACT_H
+
+#include "SimTypes.h"
+
+// Contact between a reference edge of one polygon and an incident edge of the
+// other, found by clipping the incident edge against the reference edge's side
+// planes. Points are kept as parameters along the incident edge so they can
+// be re-evaluated after either polygon moves.
+struct ContactManifold {
+    Vec2 normal = Vec2::Zero();  // unit, from the reference toward the incident polygon
+    int referenceEdge = -1;      // edge i runs from vertex i to vertex i + 1
+    int incidentEdge = -1;
+    int count = 0;               // 0, 1 or 2 points
+    Real incidentT[2] = { 0.0, 0.0 };
+    Real separation[2] = { 0.0, 0.0 };  // negative when penetrating
+};
+
+// Builds the manifold of polygon xi (incident) against polygon xr (reference)
+// for the collision normal n, which points from xr toward xi. Returns false
+// when no point of the incident edge lies behind the reference edge, or, for
+// a speculative manifold, within speculative of it.
+bool buildManifold(const Vec2* xr, int nr, const Vec2* xi, int ni, const Vec2& n, ContactManifold& m,
+    Real speculative = 0.0);
+
+#endif
@@ -0,0 +1,52 @@
+#include "ContactCache.h"
+#include "Polygon.h"
+
+#include <algorithm>
+
+using namespace std;
+
+uint64_t ContactCache::key(const Polygon& a, const Polygon& b) {
+    uint32_t lo = static_cast<uint32_t>(std::min(a.getId(), b.getId()));
+    uint32_t hi = static_cast<uint32_t>(std::max(a.getId(), b.getId()));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+void ContactCache::beginFrame() {
+    ++frame;
+}
+
+void ContactCache::touch(const Polygon& a, const Polygon& b) {
+    uint64_t k = key(a, b);
+    auto it = pairs.find(k);
+    if (it == pairs.end()) {
+        if (spare.empty()) {
+            it = pairs.emplace(k, Entry()).first;
+        }
+        else {
+            Map::node_type node = std::move(spare.back());
+            spare.pop_back();
+            node.key() = k;
+            node.mapped() = Entry();
+            it = pairs.insert(std::move(node)).position;
+        }
+    }
+    it->second.lastTouched = frame;
+}
+
+CachedContact* ContactCache::find(const Polygon& a, const Polygon& b) {
+    auto it = pairs.find(key(a, b));
+    return it != pairs.end() ? &it->second.contact : nullptr;
+}
+
+void ContactCache::endFrame() {
+    for (auto it = pairs.begin(); it != pairs.end(); ) {
+        if (it->second.lastTouched != frame)
+            spare.push_back(pairs.extract(it++));
+        else
+            ++it;
+    }
+}
+
+void ContactCache::clear() {
+    while (!pairs.empty()) spare.push_back(pairs.extract(pairs.begin()));
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef CONTACTCACHE_H
+#define CONTACTCACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Contact.h"
+
+class Polygon;
+
+// Contact table entry of one polygon pair. The world begins a frame of the
+// cache for every solver substep, and almost all of an entry lives for just
+// that frame: the manifold is built on the first collision iteration and
+// reused by the rest, which accumulate their impulses in it. The
+// accumulators keep each point's push from going negative, bound friction,
+// and give the loads World::publishContacts reports. Only the separating
+// axis is carried into later frames.
+//
+// Contacts are not warm started. Re-applying the last substep's impulses,
+// matched by feature, halved penetration but toppled towers and walls that
+// stand without it at the lower quality levels, in every body mode; the
+// solve is positional and velocities come from positions, so a push that
+// is not needed again turns into motion. Seeding the accumulators without
+// applying them changed nothing.
+struct CachedContact {
+    // This frame
+    ContactManifold manifold;
+    int referenceId = -1;               // polygon that owns the reference edge
+    Real normalImpulse[2] = { 0.0, 0.0 };  // accumulated positional impulse per point
+    Real tangentImpulse[2] = { 0.0, 0.0 }; // friction, along (-normal.y, normal.x)
+    unsigned frame = 0;                 // frame the manifold was built in
+    bool built = false;
+
+    // Kept across frames
+    Vec2 separatingAxis = Vec2::Zero();  // unit axis that last kept the pair apart, zero if none
+};
+
+// World-level store of pair contacts, keyed by polygon id. Pairs must be
+// registered with touch() before a (possibly parallel) step; during the step
+// find() only reads the table, and each pair is solved by a single polygon.
+// Entries of dropped pairs are kept and handed to new pairs, so once the
+// number of pairs has peaked, pairs coming and going allocate nothing.
+class ContactCache {
+public:
+    void beginFrame();
+    void touch(const Polygon& a, const Polygon& b);
+    CachedContact* find(const Polygon& a, const Polygon& b);
+
+    // Drops pairs that were not touched this frame
+    void endFrame();
+
+    // Calls visit(lowerId, higherId, contact) for every pair, in no
+    // particular order
+    template <typename Visit>
+    void forEachPair(Visit visit) const {
+        for (auto& pair : pairs) {
+            visit(static_cast<int>(pair.first & 0xffffffffu), static_cast<int>(pair.first >> 32), pair.second.contact);
+        }
+    }
+
+    unsigned currentFrame() const { return frame; }
+    int size() const { return static_cast<int>(pairs.size()); }
+    void clear();
+
+private:
+    struct Entry {
+        CachedContact contact;
+        unsigned lastTouched = 0;
+    };
+
+    static uint64_t key(const Polygon& a, const Polygon& b);
+
+    typedef std::unordered_map<uint64_t, Entry> Map;
+    Map pairs;
+    std::vector<Map::node_type> spare;  // entries of dropped pairs, for reuse
+    unsigned frame = 0;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+static atomic<unsigned> currentFrame(1);
+
+// First block of a fresh arena; later blocks grow with demand
+static const size_t minBlockSize = 64 * 1024;
+
+FrameArena& FrameArena::local() {
+    static thread_local FrameArena arena;
+    unsigned frame = currentFrame.load(memory_order_relaxed);
+    if (arena.frame != frame) {
+        arena.rewind();
+        arena.frame = frame;
+    }
+    return arena;
+}
+
+void FrameArena::nextFrame() {
+    currentFrame.fetch_add(1, memory_order_relaxed);
+}
+
+void FrameArena::rewind() {
+    // One block that held the whole of the last frame, so the next one fits
+    if (blocks.size() > 1) {
+        size_t total = frameBytes;
+        blocks.clear();
+        addBlock(total);
+    }
+    used = 0;
+    frameBytes = 0;
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    size_t size = std::max(minBlockSize, minBytes);
+    if (!blocks.empty())
+        size = std::max(size, blocks.back().size * 2);
+    blocks.push_back({ unique_ptr<char[]>(new char[size]), size });
+    used = 0;
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (blocks.empty())
+        addBlock(bytes + alignment);
+
+    for (;;) {
+        Block& block = blocks.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t start = (base + used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t end = start - base + bytes;
+        if (end <= block.size) {
+            frameBytes += end - used;
+            used = end;
+            return reinterpret_cast<void*>(start);
+        }
+        addBlock(bytes + alignment);
+    }
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for scratch data that lives at most one frame. Each thread
+// has its own arena, so parallel phases never contend for it. Memory is
+// never freed piecemeal: the arena is rewound at the first use in a new
+// frame (see nextFrame()). If a frame needed more than one block, the
+// blocks are merged into one big enough for the whole frame, so a steady
+// scene stops touching the heap after a few frames.
+class FrameArena {
+public:
+    // This thread's arena, rewound if a new frame has started since it was
+    // last used
+    static FrameArena& local();
+
+    // Starts a new frame; everything handed out before becomes invalid, on
+    // every thread. World::step calls it, so scratch on other threads must
+    // not be kept while the simulation thread steps.
+    static void nextFrame();
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+
+    std::size_t capacity() const;
+
+private:
+    FrameArena() = default;
+    void rewind();
+    void addBlock(std::size_t minBytes);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+    std::vector<Block> blocks;  // the last one is being filled
+    std::size_t used = 0;       // bytes taken from the last block
+    std::size_t frameBytes = 0; // bytes handed out this frame, over all blocks
+    unsigned frame = 0;
+};
+
+// Standard allocator on the calling thread's frame arena. Deallocation is a
+// no-op; the memory goes back when the frame ends.
+template <typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator() : arena(&FrameArena::local()) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    FrameArena* arena;
+};
+
+// A vector for scratch data of the current frame, on this thread's arena
+template <typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,184 @@
+#include "GjkEpa.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// Relative change below which an iteration counts as no progress
+static const Real tolerance = std::sqrt(numeric_limits<Real>::epsilon());
+
+// Largest polytope EPA grows; a - b has at most na + nb corners
+static const int maxPolytope = 64;
+
+static Real cross(const Vec2& u, const Vec2& v) {
+    return u.x() * v.y() - u.y() * v.x();
+}
+
+// Point of a - b furthest along d
+static Vec2 support(const Vec2* a, int na, const Vec2* b, int nb, const Vec2& d) {
+    int ia = 0, ib = 0;
+    Real bestA = a[0].dot(d), bestB = -b[0].dot(d);
+    for (int i = 1; i < na; ++i) {
+        Real s = a[i].dot(d);
+        if (s > bestA) {
+            bestA = s;
+            ia = i;
+        }
+    }
+    for (int i = 1; i < nb; ++i) {
+        Real s = -b[i].dot(d);
+        if (s > bestB) {
+            bestB = s;
+            ib = i;
+        }
+    }
+    return a[ia] - b[ib];
+}
+
+// Closest point to the origin on segment p-q. Returns 0 or 1 when it is
+// that end point, -1 when it lies inside.
+static int closestOnSegment(const Vec2& p, const Vec2& q, Vec2& closest) {
+    Vec2 e = q - p;
+    Real ee = e.squaredNorm();
+    Real t = ee > 0.0 ? -p.dot(e) / ee : 0.0;
+    if (t <= 0.0) {
+        closest = p;
+        return 0;
+    }
+    if (t >= 1.0) {
+        closest = q;
+        return 1;
+    }
+    closest = p + t * e;
+    return -1;
+}
+
+// Replaces v with the point of the simplex closest to the origin and drops
+// the corners not needed to reach it. Returns false when the simplex is a
+// triangle around the origin.
+static bool reduceSimplex(Vec2* s, int& count, Vec2& v) {
+    if (count == 1) {
+        v = s[0];
+        return true;
+    }
+    if (count == 2) {
+        int end = closestOnSegment(s[0], s[1], v);
+        if (end >= 0) {
+            s[0] = s[end];
+            count = 1;
+        }
+        return true;
+    }
+
+    // Triangle: the origin is inside when it is on the same side of all
+    // three edges
+    Real c0 = cross(s[1] - s[0], -s[0]);
+    Real c1 = cross(s[2] - s[1], -s[1]);
+    Real c2 = cross(s[0] - s[2], -s[2]);
+    if ((c0 >= 0.0 && c1 >= 0.0 && c2 >= 0.0) || (c0 <= 0.0 && c1 <= 0.0 && c2 <= 0.0))
+        return false;
+
+    // Otherwise the closest point is on one of the edges
+    Vec2 corners[3] = { s[0], s[1], s[2] };
+    Real best = numeric_limits<Real>::infinity();
+    for (int i = 0; i < 3; ++i) {
+        const Vec2& p = corners[i];
+        const Vec2& q = corners[(i + 1) % 3];
+        Vec2 closest;
+        int end = closestOnSegment(p, q, closest);
+        if (closest.squaredNorm() < best) {
+            best = closest.squaredNorm();
+            v = closest;
+            if (end < 0) {
+                s[0] = p;
+                s[1] = q;
+                count = 2;
+            }
+            else {
+                s[0] = end == 0 ? p : q;
+                count = 1;
+            }
+        }
+    }
+    return true;
+}
+
+GjkResult gjkEpa(const Vec2* a, int na, const Vec2* b, int nb, Real gap,
+    Vec2& normal, Real& depth)
+{
+    const int maxIterations = na + nb + 8;
+
+    // GJK: walk a simplex of a - b toward the origin
+    Vec2 s[3];
+    int count = 0;
+    Vec2 v = a[0] - b[0];
+    for (int iter = 0;; ++iter) {
+        if (iter == maxIterations) return GjkResult::Close;
+
+        Real vv = v.squaredNorm();
+        if (vv == 0.0) return GjkResult::Close;  // touching
+
+        Vec2 w = support(a, na, b, nb, -v);
+        Real vw = v.dot(w);
+
+        // Every point x of a - b has x.v >= w.v, so the polygons are at
+        // least w.v / |v| apart
+        if (vw > 0.0 && vw * vw > gap * gap * vv) {
+            normal = v / std::sqrt(vv);
+            return GjkResult::Apart;
+        }
+
+        // No closer point left to find: apart by |v|
+        if (vv - vw <= tolerance * vv) return GjkResult::Close;
+
+        s[count++] = w;
+        if (!reduceSimplex(s, count, v)) break;
+    }
+
+    // A flat triangle has no inside for EPA to grow from
+    if (std::abs(cross(s[1] - s[0], s[2] - s[0])) <= tolerance * tolerance)
+        return GjkResult::Close;
+
+    // EPA: grow a counter-clockwise polytope inside a - b until its edge
+    // nearest the origin is an edge of a - b itself
+    Vec2 poly[maxPolytope];
+    int n = 3;
+    poly[0] = s[0];
+    poly[1] = s[1];
+    poly[2] = s[2];
+    if (cross(s[1] - s[0], s[2] - s[0]) < 0.0) std::swap(poly[1], poly[2]);
+
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        int nearest = -1;
+        Real nearestDistance = numeric_limits<Real>::infinity();
+        Vec2 nearestNormal = Vec2::Zero();
+        for (int i = 0; i < n; ++i) {
+            Vec2 e = poly[(i + 1) % n] - poly[i];
+            Real length = e.norm();
+            if (length <= 0.0) continue;
+            Vec2 outward(e.y() / length, -e.x() / length);
+            Real distance = outward.dot(poly[i]);
+            if (distance < nearestDistance) {
+                nearestDistance = distance;
+                nearestNormal = outward;
+                nearest = i;
+            }
+        }
+        if (nearest < 0) return GjkResult::Close;
+
+        Vec2 w = support(a, na, b, nb, nearestNormal);
+        if (w.dot(nearestNormal) - nearestDistance <= tolerance * std::max((Real)1.0, nearestDistance)) {
+            normal = nearestNormal;
+            depth = nearestDistance;
+            return GjkResult::Overlapping;
+        }
+
+        if (n == maxPolytope) return GjkResult::Close;
+        for (int i = n; i > nearest + 1; --i) poly[i] = poly[i - 1];
+        poly[nearest + 1] = w;
+        ++n;
+    }
+    return GjkResult::Close;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef GJKEPA_H
+#define GJKEPA_H
+
+#include "SimTypes.h"
+
+// GJK and EPA on the Minkowski difference a - b of two convex polygons.
+// Each support query is one pass over the vertices, and a pair takes a few
+// queries, so the cost grows with na + nb where the separating-axis test
+// projects both polygons onto every edge normal and grows with their
+// product. Vertices may come in either winding.
+
+enum class GjkResult {
+    Apart,        // more than gap apart along normal (unit)
+    Close,        // apart, but within gap (or too degenerate to tell)
+    Overlapping,  // normal and depth are set
+};
+
+// Tests polygons a and b against each other. When they overlap, EPA finds
+// the minimum translation: b must move by depth along normal (unit, from a
+// toward b) for the two to just touch. For polygons that direction is
+// always an edge normal of one of them, the same axis SAT would pick.
+GjkResult gjkEpa(const Vec2* a, int na, const Vec2* b, int nb, Real gap,
+    Vec2& normal, Real& depth);
+
+#endif
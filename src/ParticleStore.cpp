@@ -0,0 +1,59 @@
+#include "ParticleStore.h"
+
+using namespace std;
+
+template <typename Scalar>
+int ParticleStoreT<Scalar>::allocate(int count) {
+    int handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else {
+        handle = static_cast<int>(ranges.size());
+        ranges.push_back({ 0, 0 });
+    }
+
+    // New ranges always go at the tail so existing ranges never move
+    ranges[handle] = { totalParticles(), count };
+    x.resize(x.size() + count, Vec::Zero());
+    p.resize(p.size() + count, Vec::Zero());
+    stepStart.resize(stepStart.size() + count, Vec::Zero());
+    v.resize(v.size() + count, Vec::Zero());
+    w.resize(w.size() + count, Scalar(1));
+    return handle;
+}
+
+template <typename Scalar>
+void ParticleStoreT<Scalar>::release(int handle) {
+    Range r = ranges[handle];
+
+    // Slide the tail down over the released range to keep the arrays packed
+    auto erase = [&](auto& a) {
+        a.erase(a.begin() + r.first, a.begin() + r.first + r.count);
+        };
+    erase(x);
+    erase(p);
+    erase(stepStart);
+    erase(v);
+    erase(w);
+
+    for (auto& other : ranges) {
+        if (other.first > r.first) {
+            other.first -= r.count;
+        }
+    }
+
+    ranges[handle] = { 0, 0 };
+    freeHandles.push_back(handle);
+}
+
+template <typename Scalar>
+shared_ptr<ParticleStoreT<Scalar>> ParticleStoreT<Scalar>::shared() {
+    // Polygons hold a reference too, so the store outlives static teardown
+    static shared_ptr<ParticleStoreT> store = make_shared<ParticleStoreT>();
+    return store;
+}
+
+template class ParticleStoreT<float>;
+template class ParticleStoreT<double>;
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef PARTICLESTORE_H
+#define PARTICLESTORE_H
+
+#include <vector>
+#include <memory>
+
+#include "SimTypes.h"
+
+// World-level particle storage laid out as structure-of-arrays.
+// Each polygon owns one contiguous range, addressed through a handle so the
+// arrays can stay packed when polygons are removed.
+template <typename Scalar>
+class ParticleStoreT
+{
+public:
+    typedef Vec2T<Scalar> Vec;
+
+    int allocate(int count);
+    void release(int handle);
+
+    int begin(int handle) const { return ranges[handle].first; }
+    int size(int handle) const { return ranges[handle].count; }
+    int totalParticles() const { return static_cast<int>(x.size()); }
+
+    // Remembers the current positions as where the next world step starts,
+    // so drawing can blend between the last two steps
+    void markStepStart() { stepStart = x; }
+
+    // Store shared by every polygon in the playground
+    static std::shared_ptr<ParticleStoreT> shared();
+
+    std::vector<Vec> x;         // position
+    std::vector<Vec> p;         // previous position
+    std::vector<Vec> stepStart; // position before the latest world step
+    std::vector<Vec> v;         // velocity
+    std::vector<Scalar> w;      // inverse mass (0 = fixed)
+
+private:
+    struct Range {
+        int first;
+        int count;
+    };
+
+    std::vector<Range> ranges;
+    std::vector<int> freeHandles;
+};
+
+#endif
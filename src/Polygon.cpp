@@ -1,6 +1,11 @@
 #include "Polygon.h"
-#include "Particle.h"
+#include "ParticleStore.h"
 #include "Spring.h"
+#include "SatKernels.h"
+#include "GjkEpa.h"
+#include "Contact.h"
+#include "ContactCache.h"
+#include "FrameArena.h"
 
 #include <GL/glew.h>
 #include <cmath>
@@ -14,528 +19,903 @@
 using namespace std;
 using namespace Eigen;
 
-Polygon::Polygon(const Vector3d& pos, int numEdges, double width, double height, double rotation) {
-    generateRegularPolygon(pos, numEdges, width, height, rotation);
+static int nextPolygonId = 0;
+
+Polygon::Polygon(const Vec2& pos, int numEdges, Real width, Real height, Real rotation, BodyMode mode,
+    Real springCompliance)
+    : store(ParticleStore::shared()),
+    id(nextPolygonId++),
+    mode(mode)
+{
+    handle = store->allocate(numEdges);
+    generateRegularPolygon(pos, numEdges, width, height, rotation, springCompliance);
+    updateGeometry();
+
+    // The shape as built is the rest shape, and the rigid pose at angle 0
+    const ParticleStore& S = *store;
+    for (int i = 0; i < numEdges; ++i) {
+        restShape.push_back(S.x[particleBegin() + i] - geometry.centroid);
+    }
+    rigid.position = geometry.centroid;
+    rigid.previousPosition = rigid.position;
 }
 
 
 Polygon::Polygon(const Polygon& other)
-    : fillColor(other.fillColor),
+    : enable_shared_from_this<Polygon>(),
+    defaultOutlineColor(other.defaultOutlineColor),
     outlineColor(other.outlineColor),
-    defaultOutlineColor(other.defaultOutlineColor)
+    fillColor(other.fillColor),
+    springs(other.springs),
+    store(other.store),
+    id(nextPolygonId++),
+    mode(other.mode),
+    rigid(other.rigid),
+    edges(other.edges),
+    geometry(other.geometry),
+    collisionThickness(other.collisionThickness),
+    shapeCompliance(other.shapeCompliance),
+    restShape(other.restShape)
 {
-    // Step 1: Deep-copy particles
-    particles.reserve(other.particles.size());
-    for (const auto& p : other.particles) {
-        particles.push_back(std::make_shared<Particle>(*p));  // clone the particle
+    // Deep-copy particles into a fresh range; springs and edges use local
+    // indices so they carry over unchanged
+    int n = other.numParticles();
+    handle = store->allocate(n);
+
+    ParticleStore& S = *store;
+    int src = other.particleBegin();
+    int dst = particleBegin();
+    for (int i = 0; i < n; ++i) {
+        S.x[dst + i] = S.x[src + i];
+        S.p[dst + i] = S.p[src + i];
+        S.stepStart[dst + i] = S.stepStart[src + i];
+        S.v[dst + i] = S.v[src + i];
+        S.w[dst + i] = S.w[src + i];
     }
+}
+
+Polygon::~Polygon() {
+    store->release(handle);
+}
+
+int Polygon::particleBegin() const {
+    return store->begin(handle);
+}
 
-    // Step 2: Deep-copy springs
-    springs.reserve(other.springs.size());
-    for (const auto& s : other.springs) {
-        // Find indices of spring endpoints in original polygon
-        auto it0 = std::find(other.particles.begin(), other.particles.end(), s->p0);
-        auto it1 = std::find(other.particles.begin(), other.particles.end(), s->p1);
+int Polygon::numParticles() const {
+    return store->size(handle);
+}
+
+const Vec2& Polygon::particlePosition(int i) const {
+    return store->x[particleBegin() + i];
+}
+
+
+void Polygon::updateGeometry() {
+    const ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
+    PolygonGeometry& g = geometry;
 
-        assert(it0 != other.particles.end() && it1 != other.particles.end());
-        int i0 = static_cast<int>(std::distance(other.particles.begin(), it0));
-        int i1 = static_cast<int>(std::distance(other.particles.begin(), it1));
+    g.nx.resize(n);
+    g.ny.resize(n);
+    g.aabbMin = S.x[b];
+    g.aabbMax = S.x[b];
 
-        springs.push_back(std::make_shared<Spring>(particles[i0], particles[i1], s->alpha));
+    Vec2 sum(0, 0);
+    Real mass = 0.0;
+    Real maxSpeedSq = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const Vec2& x = S.x[b + i];
+        sum += x;
+        maxSpeedSq = std::max(maxSpeedSq, S.v[b + i].squaredNorm());
+        g.aabbMin = g.aabbMin.cwiseMin(x);
+        g.aabbMax = g.aabbMax.cwiseMax(x);
+
+        Vec2 e = S.x[b + (i + 1) % n] - x;
+        Vec2 axis = Vec2(-e.y(), e.x()).normalized();
+        g.nx[i] = axis.x();
+        g.ny[i] = axis.y();
+
+        if (S.w[b + i] > 0.0)
+            mass += 1.0 / S.w[b + i];
     }
+    g.centroid = sum / (Real)n;
+    g.invMass = mass > 0.0 ? 1.0 / mass : 0.0;
+    g.maxSpeed = std::sqrt(maxSpeedSq);
+
+    Real maxDistSq = 0.0;
+    for (int i = 0; i < n; ++i) {
+        maxDistSq = std::max(maxDistSq, (S.x[b + i] - g.centroid).squaredNorm());
+    }
+    g.boundingRadius = std::sqrt(maxDistSq);
+
+    Real inertia = 0.0;
+    for (int i = 0; i < n; ++i) {
+        if (S.w[b + i] > 0.0)
+            inertia += (S.x[b + i] - g.centroid).squaredNorm() / S.w[b + i];
+    }
+    g.invInertia = inertia > 0.0 ? 1.0 / inertia : 0.0;
 }
 
+Vec2 Polygon::getCenter() const {
+    return geometry.centroid;
+}
 
-Eigen::Vector2f Polygon::getCenter() const {
-    Eigen::Vector2f center(0, 0);
-    for (const auto& p : particles) {
-        center += Eigen::Vector2f(p->x.x(), p->x.y());
+void Polygon::wake() {
+    sleeping = false;
+    sleepTimer = 0.0;
+}
+
+void Polygon::sleep() {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
+    for (int i = b; i < e; ++i) {
+        S.v[i].setZero();
+        S.p[i] = S.x[i];
     }
-    center /= (float)particles.size();
-    return center;
+    sleeping = true;
+}
+
+Real Polygon::updateSleepTimer(Real timeStep, Real quietSpeed) {
+    // Judged on net motion since the last call: within a step, resting
+    // polygons still sag under gravity and get pushed back by neighbours
+    Vec2 centroid = liveCentroid();
+    const Vec2& corner = store->x[particleBegin()];
+
+    const Real quietDistance = quietSpeed * timeStep;
+    bool quiet = (centroid - sleepCentroid).squaredNorm() < quietDistance * quietDistance &&
+        (corner - sleepCorner).squaredNorm() < quietDistance * quietDistance;
+
+    sleepCentroid = centroid;
+    sleepCorner = corner;
+    sleepTimer = quiet ? sleepTimer + timeStep : 0.0;
+    return sleepTimer;
 }
 
-void Polygon::moveCenterTo(const Eigen::Vector3d& target) {
-    Eigen::Vector2f target2f = target.head<2>().cast<float>();
-    Eigen::Vector2f currentCenter = getCenter();
-    Eigen::Vector2f offset = target2f - currentCenter;
+uint64_t Polygon::hashState(uint64_t hash) const {
+    const ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
+
+    // Positions and velocities; p and the geometry are rebuilt from them
+    hash = hashBytes(hash, &S.x[b], n * sizeof(Vec2));
+    hash = hashBytes(hash, &S.v[b], n * sizeof(Vec2));
+    // Field by field: RigidState has padding, whose bytes are arbitrary
+    const Real rigidState[] = {
+        rigid.position.x(), rigid.position.y(),
+        rigid.previousPosition.x(), rigid.previousPosition.y(),
+        rigid.velocity.x(), rigid.velocity.y(),
+        rigid.angle, rigid.previousAngle, rigid.angularVelocity,
+    };
+    hash = hashBytes(hash, rigidState, sizeof(rigidState));
+    hash = hashBytes(hash, &meanVelocity, sizeof(meanVelocity));
+    hash = hashBytes(hash, &sleeping, sizeof(sleeping));
+    hash = hashBytes(hash, &sleepTimer, sizeof(sleepTimer));
+    hash = hashBytes(hash, &sleepCentroid, sizeof(sleepCentroid));
+    hash = hashBytes(hash, &sleepCorner, sizeof(sleepCorner));
+    return hash;
+}
 
-    for (auto& p : particles) {
-        p->x.head<2>() += offset.cast<double>();
-        p->p.head<2>() += offset.cast<double>();
+void Polygon::moveCenterTo(const Vec2& target) {
+    wake();
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
+
+    Vec2 center(0, 0);
+    for (int i = b; i < e; ++i) {
+        center += S.x[i];
     }
+    center /= (Real)numParticles();
+
+    Vec2 offset = target - center;
+    for (int i = b; i < e; ++i) {
+        S.x[i] += offset;
+        S.p[i] += offset;
+        S.stepStart[i] += offset;  // a move is not motion to blend over
+    }
+    updateGeometry();
 }
 
-void Polygon::generateRegularPolygon(const Vector3d& center, int numEdges, double width, double height, double rotation) {
-    double radiusX = width / 2.0;
-    double radiusY = height / 2.0;
+Vec2 Polygon::regularCorner(const Vec2& center, int i, int numEdges, Real width, Real height, Real rotation) {
+    Real angle = 2.0 * M_PI * i / numEdges + rotation;
+    return center + Vec2(width / 2.0 * cos(angle), height / 2.0 * sin(angle));
+}
+
+void Polygon::generateRegularPolygon(const Vec2& center, int numEdges, Real width, Real height, Real rotation,
+    Real springCompliance)
+{
+    ParticleStore& S = *store;
+    const int b = particleBegin();
 
     // Create one particle per corner
     for (int i = 0; i < numEdges; ++i) {
-        double angle = 2.0 * M_PI * i / numEdges + rotation;
-        auto p = make_shared<Particle>();
-        p->x = center + Vector3d(radiusX * cos(angle), radiusY * sin(angle), 0);
-        p->v = Vector3d::Zero();
-        p->fixed = false;
-        particles.push_back(p);
+        S.x[b + i] = regularCorner(center, i, numEdges, width, height, rotation);
+        S.p[b + i] = S.x[b + i];
+        S.stepStart[b + i] = S.x[b + i];
+        S.v[b + i] = Vec2::Zero();
+        S.w[b + i] = 1.0;
     }
 
+    auto restLength = [&](int i0, int i1) {
+        return (S.x[b + i1] - S.x[b + i0]).norm();
+        };
+
     for (int i = 0; i < numEdges; ++i) {
         int next = (i + 1) % numEdges;
         int prev = (i - 1 + numEdges) % numEdges;
+        edges.push_back({ i, next });
+
+        // Only spring-mode polygons are held together by springs
+        if (mode != BodyMode::Springs) continue;
 
         // Structural spring (edge)
-        springs.push_back(make_shared<Spring>(particles[i], particles[next], 1.0));
-        edges.push_back({ particles[i], particles[next] });
+        springs.add(i, next, restLength(i, next), springCompliance);
 
         // Shear springs (for quadrilaterals and up)
         if (numEdges >= 4) {
-            springs.push_back(make_shared<Spring>(particles[i], particles[prev], 1.0));
+            springs.add(i, prev, restLength(i, prev), springCompliance);
         }
 
         // Bending springs (connect to next-next)
         if (numEdges >= 4) {
             int next2 = (i + 2) % numEdges;
-            springs.push_back(make_shared<Spring>(particles[i], particles[next2], 1.0));
+            springs.add(i, next2, restLength(i, next2), springCompliance);
         }
     }
 
-    double totalLength = 0.0;
-    for (const auto& edge : edges) {
-        totalLength += (edge.p0->x - edge.p1->x).norm();
-    }
-    double avgLength = totalLength / edges.size();
     collisionThickness = .1; // More conservative, consistent
 }
 
 
-void Polygon::applyForces(double timeStep, const Vector3d& gravity, double damping) {
-    for (auto& p : particles) {
-        if (!p->fixed) {
-            p->p = p->x;
-            p->v += gravity * timeStep;
-            p->v *= damping;
-        }
-    }
-}
-
-bool Polygon::isTouching(const std::shared_ptr<Polygon>& other) const {
-    auto getEdges = [](const std::vector<std::shared_ptr<Particle>>& particles) {
-        std::vector<std::pair<Vector2d, Vector2d>> edges;
-        int n = particles.size();
-        for (int i = 0; i < n; ++i) {
-            Vector2d a = particles[i]->x.head<2>();
-            Vector2d b = particles[(i + 1) % n]->x.head<2>();
-            edges.push_back({ a, b });
-        }
-        return edges;
-        };
+void Polygon::applyForces(Real timeStep, const Vec2& gravity, Real damping) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-    auto project = [](const std::vector<std::shared_ptr<Particle>>& pts, const Vector2d& axis, double& min, double& max) {
-        min = max = pts[0]->x.head<2>().dot(axis);
-        for (auto& p : pts) {
-            double proj = p->x.head<2>().dot(axis);
-            min = std::min(min, proj);
-            max = std::max(max, proj);
+    if (mode == BodyMode::Rigid) {
+        readRigidState();
+        if (geometry.invMass > 0.0) {
+            rigid.velocity += gravity * timeStep;
+            rigid.velocity *= damping;
+            rigid.angularVelocity *= damping;
         }
-        };
-
-    auto edgesA = getEdges(particles);
-    auto edgesB = getEdges(other->particles);
-
-    auto checkAxes = [&](const std::vector<std::pair<Vector2d, Vector2d>>& edges) {
-        for (auto& edge : edges) {
-            Vector2d e = edge.second - edge.first;
-            Vector2d axis(-e.y(), e.x());
-            axis.normalize();
-
-            double minA, maxA, minB, maxB;
-            project(particles, axis, minA, maxA);
-            project(other->particles, axis, minB, maxB);
+        for (int i = b; i < e; ++i) S.p[i] = S.x[i];
+        return;
+    }
 
-            if (maxA < minB || maxB < minA)
-                return false;  // Separating axis found
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0) {
+            S.p[i] = S.x[i];
+            S.v[i] += gravity * timeStep;
+            S.v[i] *= damping;
         }
-        return true;
-        };
-
-    return checkAxes(edgesA) && checkAxes(edgesB);
+    }
 }
 
+void Polygon::integratePosition(Real timeStep) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-void Polygon::integratePosition(double timeStep) {
-    for (auto& p : particles) {
-        if (!p->fixed) {
-            p->p = p->x;
-            p->x += p->v * timeStep;
-        }
+    if (mode == BodyMode::Rigid) {
+        for (int i = b; i < e; ++i) S.p[i] = S.x[i];
+        rigid.previousPosition = rigid.position;
+        rigid.previousAngle = rigid.angle;
+        rigid.position += rigid.velocity * timeStep;
+        rigid.angle += rigid.angularVelocity * timeStep;
+        placeRigidParticles();
+        return;
     }
-}
 
-bool Polygon::isAbove(const std::shared_ptr<Polygon>& other) const {
-    // Simple Y-based check: average center of mass
-    double thisY = 0.0, otherY = 0.0;
-    for (auto& p : particles) thisY += p->x.y();
-    for (auto& p : other->particles) otherY += p->x.y();
-    thisY /= particles.size();
-    otherY /= other->particles.size();
-    return thisY > otherY + 0.01; // small bias
+    // Fixed particles get a start position too; speculative contacts
+    // are built from it
+    for (int i = b; i < e; ++i) {
+        S.p[i] = S.x[i];
+        if (S.w[i] > 0.0)
+            S.x[i] += S.v[i] * timeStep;
+    }
 }
 
-void Polygon::resolveCollisionsWith(const std::shared_ptr<Polygon>& other, double timeStep) {
-    struct MTV {
-        Vector2d axis;
-        double depth;
-    };
-
-    double totalNormalImpulse = 0.0;
-
+static Vec2 centroidOf(const Vec2* x, int n) {
+    Vec2 c = Vec2::Zero();
+    for (int i = 0; i < n; ++i) c += x[i];
+    return c / (Real)n;
+}
 
-    MTV bestMTV;
-    bestMTV.depth = std::numeric_limits<double>::infinity();
+// Whether the bounding boxes of a and b come within gap of each other
+static bool boundsWithin(const Vec2* a, int na, const Vec2* b, int nb, Real gap) {
+    Vec2 minA = a[0], maxA = a[0], minB = b[0], maxB = b[0];
+    for (int i = 1; i < na; ++i) {
+        minA = minA.cwiseMin(a[i]);
+        maxA = maxA.cwiseMax(a[i]);
+    }
+    for (int i = 1; i < nb; ++i) {
+        minB = minB.cwiseMin(b[i]);
+        maxB = maxB.cwiseMax(b[i]);
+    }
+    return minA.x() - gap <= maxB.x() && minB.x() - gap <= maxA.x() &&
+        minA.y() - gap <= maxB.y() && minB.y() - gap <= maxA.y();
+}
 
-    auto getEdges = [](const std::vector<std::shared_ptr<Particle>>& particles) {
-        std::vector<std::pair<Vector2d, Vector2d>> edges;
-        int n = particles.size();
-        for (int i = 0; i < n; ++i) {
-            Vector2d a = particles[i]->x.head<2>();
-            Vector2d b = particles[(i + 1) % n]->x.head<2>();
-            edges.push_back({ a, b });
+void Polygon::resolveCollisionsWith(const std::shared_ptr<Polygon>& other, Real timeStep, ContactCache& contacts,
+    int gjkMinVertices) {
+    ParticleStore& S = *store;
+    const PolygonGeometry& ga = geometry;
+    const PolygonGeometry& gb = other->geometry;
+
+    if (ga.invMass + gb.invMass < 1e-8) return;
+
+    // Pairs the world did not register are solved cold
+    CachedContact scratch;
+    CachedContact* cached = contacts.find(*this, *other);
+    CachedContact& c = cached ? *cached : scratch;
+
+    bool fresh = !c.built || c.frame != contacts.currentFrame();
+    if (fresh) {
+        // First iteration this frame: build the manifold
+        c.built = true;
+        c.frame = contacts.currentFrame();
+        c.manifold.count = 0;
+
+        // A pair that can close more than a fraction of its smaller member
+        // within the substep could pass right through each other. Its
+        // manifold is built speculatively, from where the polygons started
+        // the substep, keeping points as far out as the pair can travel; the
+        // solve then stops them at the face they were heading for.
+        Real travel = (ga.maxSpeed + gb.maxSpeed) * timeStep;
+        bool speculative = travel > speculativeFraction * std::min(ga.boundingRadius, gb.boundingRadius);
+        const vector<Vec2>& X = speculative ? S.p : S.x;
+        Real gap = speculative ? travel : 0.0;
+
+        const Vec2* xa = &X[particleBegin()];
+        const Vec2* xb = &X[other->particleBegin()];
+        const int na = numParticles(), nb = other->numParticles();
+
+        // Cheap rejections before the full test: bounds that are apart, or
+        // the axis that kept the pair apart last time, which in a resting
+        // pile nearly always still does
+        if (!boundsWithin(xa, na, xb, nb, gap)) return;
+        if (!c.separatingAxis.isZero()) {
+            Real depth;
+            if (satMinOverlap(xa, na, xb, nb, &c.separatingAxis.x(), &c.separatingAxis.y(), 1, depth, gap) < 0)
+                return;
+            c.separatingAxis.setZero();
         }
-        return edges;
-        };
 
-    auto projectPolygon = [](const std::vector<std::shared_ptr<Particle>>& points, const Vector2d& axis, double& min, double& max) {
-        min = max = points[0]->x.head<2>().dot(axis);
-        for (const auto& p : points) {
-            double proj = p->x.head<2>().dot(axis);
-            if (proj < min) min = proj;
-            if (proj > max) max = proj;
+        // The polygon owning the minimum-overlap axis supplies the reference edge
+        Polygon* ref = this;
+        Polygon* inc = other.get();
+        Vec2 n;
+
+        // SAT projects both polygons onto every edge normal, so its cost
+        // grows with na * nb; past gjkMinVertices GJK/EPA is cheaper. It
+        // finds the same axis, which is the edge normal of a or b that
+        // lines up with the penetration direction. Pairs that are apart
+        // but within the gap are left to SAT, since closest points need
+        // not lie on an edge the manifold could use.
+        GjkResult gjk = GjkResult::Close;
+        if (na + nb >= gjkMinVertices) {
+            Real depth;
+            gjk = gjkEpa(xa, na, xb, nb, gap, n, depth);
+            if (gjk == GjkResult::Apart) {
+                c.separatingAxis = n;
+                return;
+            }
         }
-        };
 
-    auto edgesA = getEdges(particles);
-    auto edgesB = getEdges(other->particles);
-
-    auto testAxes = [&](const std::vector<std::pair<Vector2d, Vector2d>>& edges) {
-        for (const auto& edge : edges) {
-            Vector2d e = edge.second - edge.first;
-            Vector2d axis = Vector2d(-e.y(), e.x()).normalized();
-
-            double minA, maxA, minB, maxB;
-            projectPolygon(particles, axis, minA, maxA);
-            projectPolygon(other->particles, axis, minB, maxB);
+        if (gjk == GjkResult::Overlapping) {
+            // The penetration direction lines up with one edge normal of
+            // each polygon (axes, as SAT uses them, so either sign)
+            int bestA = 0, bestB = 0;
+            Real alignA = -1.0, alignB = -1.0;
+            for (int i = 0; i < na; ++i) {
+                Real d = std::abs(ga.nx[i] * n.x() + ga.ny[i] * n.y());
+                if (d > alignA) {
+                    alignA = d;
+                    bestA = i;
+                }
+            }
+            for (int i = 0; i < nb; ++i) {
+                Real d = std::abs(gb.nx[i] * n.x() + gb.ny[i] * n.y());
+                if (d > alignB) {
+                    alignB = d;
+                    bestB = i;
+                }
+            }
 
-            double overlap = std::min(maxA, maxB) - std::max(minA, minB);
-            if (overlap < 0) return false; // Separating axis -> no collision
+            // Between the two, the reference is picked as SAT would
+            Real depthA, depthB;
+            satMinOverlap(xa, na, xb, nb, &ga.nx[bestA], &ga.ny[bestA], 1, depthA, gap);
+            satMinOverlap(xa, na, xb, nb, &gb.nx[bestB], &gb.ny[bestB], 1, depthB, gap);
+            n = Vec2(ga.nx[bestA], ga.ny[bestA]);
+            if (depthB < depthA) {
+                std::swap(ref, inc);
+                n = Vec2(gb.nx[bestB], gb.ny[bestB]);
+            }
+        }
+        else {
+            // Candidate axes are the cached edge normals of both polygons
+            int bestA, bestB;
+            Real depthA, depthB;
+            if (!satPair(xa, na, ga.nx.data(), ga.ny.data(), xb, nb, gb.nx.data(), gb.ny.data(),
+                bestA, depthA, bestB, depthB, gap)) {
+                // Separating axis -> no collision
+                c.separatingAxis = bestA >= 0 ? Vec2(ga.nx[bestA], ga.ny[bestA]) : Vec2(gb.nx[bestB], gb.ny[bestB]);
+                return;
+            }
 
-            if (overlap < bestMTV.depth) {
-                bestMTV.depth = overlap;
-                bestMTV.axis = axis;
+            n = Vec2(ga.nx[bestA], ga.ny[bestA]);
+            if (depthB < depthA) {
+                std::swap(ref, inc);
+                n = Vec2(gb.nx[bestB], gb.ny[bestB]);
             }
         }
-        return true;
-        };
+        if (n.dot(centroidOf(&X[inc->particleBegin()], inc->numParticles()) -
+            centroidOf(&X[ref->particleBegin()], ref->numParticles())) < 0)
+            n = -n;
+
+        if (!buildManifold(&X[ref->particleBegin()], ref->numParticles(),
+            &X[inc->particleBegin()], inc->numParticles(), n, c.manifold, gap)) return;
+        c.referenceId = ref->getId();
+        for (int k = 0; k < c.manifold.count; ++k) {
+            c.normalImpulse[k] = 0.0;
+            c.tangentImpulse[k] = 0.0;
+        }
+    }
+
+    ContactManifold& m = c.manifold;
+    if (m.count == 0) return;
+
+    Polygon* ref = this;
+    Polygon* inc = other.get();
+    if (c.referenceId != getId())
+        std::swap(ref, inc);
+    const Vec2& n = m.normal;
 
-    if (!testAxes(edgesA)) return;
-    if (!testAxes(edgesB)) return;
+    Vec2 cRef = ref->liveCentroid();
+    Vec2 cInc = inc->liveCentroid();
 
-    // At this point, collision confirmed
-    // Compute total inverse mass
-    double wThis = 1.0 / getTotalMass();
-    double wOther = 1.0 / other->getTotalMass();
-    double wSum = wThis + wOther;
+    const int rb = ref->particleBegin(), nr = ref->numParticles();
+    const int ib = inc->particleBegin(), ni = inc->numParticles();
+    const int r0 = rb + m.referenceEdge, r1 = rb + (m.referenceEdge + 1) % nr;
+    const int i0 = ib + m.incidentEdge, i1 = ib + (m.incidentEdge + 1) % ni;
 
-    if (wSum < 1e-8) return;
+    const Real mu = 0.8;  // static and dynamic friction coefficient
 
-    // Direction from this to other
-    Vector2d dir = other->getCenter().cast<double>() - getCenter().cast<double>();
-    if (dir.dot(bestMTV.axis) < 0)
-        bestMTV.axis = -bestMTV.axis;
+    // The points of a manifold are solved together (Jacobi, averaged over
+    // the points) so an evenly loaded face does not start the polygons
+    // turning just because one of its points was handled first. Impulses
+    // accumulate over the frame and may shrink again, but never below zero,
+    // which lets a later iteration back off a push an earlier one overdid.
+    Vec2 points[2];
+    Real lambdas[2] = { 0.0, 0.0 };
+    for (int k = 0; k < m.count; ++k) {
+        Real t = m.incidentT[k];
+        points[k] = S.x[i0] + t * (S.x[i1] - S.x[i0]);
+        m.separation[k] = (points[k] - S.x[r0]).dot(n);
 
-    Vector2d correction = bestMTV.axis * bestMTV.depth;
+        Real wSum = ref->contactInverseMass(points[k], n, cRef) + inc->contactInverseMass(points[k], n, cInc);
+        if (wSum < 1e-8) continue;
 
-    for (auto& p : particles) {
-        if (!p->fixed)
-            p->x.head<2>() -= correction * (wThis / wSum);
+        Real accumulated = std::max(c.normalImpulse[k] - m.separation[k] / (wSum * m.count), (Real)0.0);
+        lambdas[k] = accumulated - c.normalImpulse[k];
+        c.normalImpulse[k] = accumulated;
     }
-    for (auto& p : other->particles) {
-        if (!p->fixed)
-            p->x.head<2>() += correction * (wOther / wSum);
+
+    // Push the polygons apart as rigid bodies, so an off-centre contact
+    // also turns them
+    for (int k = 0; k < m.count; ++k) {
+        if (lambdas[k] == 0.0) continue;
+        ref->applyPositionalImpulse(points[k], -lambdas[k] * n, cRef);
+        inc->applyPositionalImpulse(points[k], lambdas[k] * n, cInc);
     }
 
-    // Apply impulse-based response to transfer momentum
-    Vector3d n3d(bestMTV.axis.x(), bestMTV.axis.y(), 0);
-    double restitution = 0.0;  // inelastic for realism
+    // Friction: undo the sliding of the contact points since the start of
+    // the step, as far as the normal impulse allows. Velocities are rebuilt
+    // from positions afterwards, so this is what the polygons keep.
+    const Vec2 tangent(-n.y(), n.x());
+    for (int k = 0; k < m.count; ++k) {
+        lambdas[k] = 0.0;
+        if (c.normalImpulse[k] == 0.0) continue;
 
-    for (auto& pa : particles) {
-        if (pa->fixed) continue;
-        for (auto& pb : other->particles) {
-            if (pb->fixed) continue;
+        Real t = m.incidentT[k];
+        Vec2 edgeRef = S.x[r1] - S.x[r0];
+        Real refLenSq = edgeRef.squaredNorm();
+        Real u = refLenSq > 1e-12 ? std::clamp((points[k] - S.x[r0]).dot(edgeRef) / refLenSq, (Real)0.0, (Real)1.0) : 0.0;
 
-            Vector3d rv = pb->v - pa->v;
-            double velAlongNormal = rv.dot(n3d);
-            if (velAlongNormal > 0) continue; // separating
+        Vec2 moveInc = (S.x[i0] - S.p[i0]) + t * ((S.x[i1] - S.p[i1]) - (S.x[i0] - S.p[i0]));
+        Vec2 moveRef = (S.x[r0] - S.p[r0]) + u * ((S.x[r1] - S.p[r1]) - (S.x[r0] - S.p[r0]));
+        Real slip = (moveInc - moveRef).dot(tangent);
 
-            double invMassA = 1.0 / pa->m;
-            double invMassB = 1.0 / pb->m;
-            double j = -(1.0 + restitution) * velAlongNormal / (invMassA + invMassB);
-            totalNormalImpulse += std::abs(j);
-            Vector3d impulse = j * n3d;
+        Real wSum = ref->contactInverseMass(points[k], tangent, cRef) + inc->contactInverseMass(points[k], tangent, cInc);
+        if (wSum < 1e-8) continue;
 
+        Real limit = mu * c.normalImpulse[k];
+        Real accumulated = std::clamp(c.tangentImpulse[k] - slip / (wSum * m.count), -limit, limit);
+        lambdas[k] = accumulated - c.tangentImpulse[k];
+        c.tangentImpulse[k] = accumulated;
+    }
 
-            pa->v -= impulse * invMassA;
-            pb->v += impulse * invMassB;
+    for (int k = 0; k < m.count; ++k) {
+        if (lambdas[k] == 0.0) continue;
+        ref->applyPositionalImpulse(points[k], -lambdas[k] * tangent, cRef);
+        inc->applyPositionalImpulse(points[k], lambdas[k] * tangent, cInc);
+    }
+}
 
-            // === Friction impulse (constraint-based) ===
-            Vector3d tangent = rv - velAlongNormal * n3d;
-            if (tangent.norm() > 1e-6) {
-                tangent.normalize();
+Vec2 Polygon::liveCentroid() const {
+    return centroidOf(&store->x[particleBegin()], numParticles());
+}
 
-                double relTanVel = rv.dot(tangent);
-                double jt = -relTanVel / (invMassA + invMassB);
+Real Polygon::contactInverseMass(const Vec2& point, const Vec2& dir, const Vec2& centroid) const {
+    Vec2 r = point - centroid;
+    Real rn = r.x() * dir.y() - r.y() * dir.x();
+    return geometry.invMass + geometry.invInertia * rn * rn;
+}
 
-                // Static + dynamic friction coefficient
-                double mu_static = 0.8;
-                double mu_dynamic = 0.8;
+void Polygon::applyPositionalImpulse(const Vec2& point, const Vec2& impulse, Vec2& centroid) {
+    if (geometry.invMass == 0.0) return;
 
-                double maxFriction = (std::abs(j) > 1e-4 && std::abs(relTanVel) < 0.05)
-                    ? mu_static * std::abs(j)
-                    : mu_dynamic * std::abs(j);
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-                double jtClamped = std::clamp(jt, -maxFriction, maxFriction);
-                Vector3d frictionImpulse = jtClamped * tangent;
+    Vec2 r = point - centroid;
+    Vec2 shift = impulse * geometry.invMass;
+    Real angle = geometry.invInertia * (r.x() * impulse.y() - r.y() * impulse.x());
 
-                pa->v -= frictionImpulse * invMassA;
-                pb->v += frictionImpulse * invMassB;
-            }
+    if (mode == BodyMode::Rigid) {
+        rigid.position += shift;
+        rigid.angle += angle;
+        placeRigidParticles();
+        centroid += shift;
+        return;
+    }
 
-        }
+    Real c = std::cos(angle), s = std::sin(angle);
 
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0) {
+            Vec2 d = S.x[i] - centroid;
+            S.x[i] = centroid + shift + Vec2(c * d.x() - s * d.y(), s * d.x() + c * d.y());
+        }
     }
-
+    centroid += shift;
 }
 
-void Polygon::applyStackingFriction(const std::vector<std::shared_ptr<Polygon>>& others) {
-    for (auto& other : others) {
-        if (other.get() == this) continue;
+void Polygon::readRigidState() {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
+
+    Vec2 center = Vec2::Zero();
+    Vec2 momentum = Vec2::Zero();
+    Real mass = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Real m = S.w[b + i] > 0.0 ? 1.0 / S.w[b + i] : 0.0;
+        center += m * S.x[b + i];
+        momentum += m * S.v[b + i];
+        mass += m;
+    }
+    if (mass == 0.0) return;
+    center /= mass;
+
+    // Angular momentum about the centre, and the best-fit pose
+    Real angularMomentum = 0.0, inertia = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Real m = S.w[b + i] > 0.0 ? 1.0 / S.w[b + i] : 0.0;
+        Vec2 r = S.x[b + i] - center;
+        const Vec2& v = S.v[b + i];
+        angularMomentum += m * (r.x() * v.y() - r.y() * v.x());
+        inertia += m * restShape[i].squaredNorm();
+    }
+
+    rigid.position = center;
+    rigid.angle = bestFitAngle(center, rigid.angle);
+    rigid.velocity = momentum / mass;
+    rigid.angularVelocity = inertia > 0.0 ? angularMomentum / inertia : 0.0;
+    placeRigidParticles();
+}
 
-        // Check vertical relationship
-        double thisY = 0.0, otherY = 0.0;
-        for (auto& p : particles) thisY += p->x.y();
-        for (auto& p : other->particles) otherY += p->x.y();
-        thisY /= particles.size();
-        otherY /= other->particles.size();
+void Polygon::placeRigidParticles() {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
 
-        // Only apply if THIS is below OTHER
-        if (thisY < otherY - 0.01 && isTouching(other)) {
-            Vector3d avgVThis = Vector3d::Zero();
-            Vector3d avgVOther = Vector3d::Zero();
-            for (auto& p : particles) avgVThis += p->v;
-            for (auto& p : other->particles) avgVOther += p->v;
-            avgVThis /= particles.size();
-            avgVOther /= other->particles.size();
+    Real c = std::cos(rigid.angle), s = std::sin(rigid.angle);
+    for (int i = 0; i < n; ++i) {
+        const Vec2& q = restShape[i];
+        S.x[b + i] = rigid.position + Vec2(c * q.x() - s * q.y(), s * q.x() + c * q.y());
+    }
+}
 
-            double relVx = avgVOther.x() - avgVThis.x();
-            double blend = 0.2; // Tune as needed
+Real Polygon::bestFitAngle(const Vec2& center, Real angle) const {
+    const ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
+
+    // The rotation that best maps the rest shape onto the particles is
+    // closed-form in 2D: atan2 of the summed cross and dot products
+    Real c = std::cos(angle), s = std::sin(angle);
+    Real dotSum = 0.0, crossSum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Real m = S.w[b + i] > 0.0 ? 1.0 / S.w[b + i] : 0.0;
+        const Vec2& q0 = restShape[i];
+        Vec2 q(c * q0.x() - s * q0.y(), s * q0.x() + c * q0.y());
+        Vec2 r = S.x[b + i] - center;
+        dotSum += m * q.dot(r);
+        crossSum += m * (q.x() * r.y() - q.y() * r.x());
+    }
+    return angle + std::atan2(crossSum, dotSum);
+}
 
-            for (auto& p : other->particles)
-                if (!p->fixed)
-                    p->v.x() -= relVx * blend;
-        }
+void Polygon::matchShape(Real timeStep) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), n = numParticles();
+
+    Vec2 center = Vec2::Zero();
+    Real mass = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Real m = S.w[b + i] > 0.0 ? 1.0 / S.w[b + i] : 0.0;
+        center += m * S.x[b + i];
+        mass += m;
+    }
+    if (mass == 0.0) return;
+    center /= mass;
+
+    // Pull every particle toward its goal in the best-fit pose, as a
+    // zero-length XPBD constraint so the give does not depend on the
+    // iteration count
+    Real angle = bestFitAngle(center, 0.0);
+    Real c = std::cos(angle), s = std::sin(angle);
+    Real alphaTilde = shapeCompliance / (timeStep * timeStep);
+    for (int i = 0; i < n; ++i) {
+        Real w = S.w[b + i];
+        if (w == 0.0) continue;
+        const Vec2& q = restShape[i];
+        Vec2 goal = center + Vec2(c * q.x() - s * q.y(), s * q.x() + c * q.y());
+        S.x[b + i] += (w / (w + alphaTilde)) * (goal - S.x[b + i]);
     }
 }
 
+void Polygon::applyStackingFriction(const Polygon& other) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
+    // Check vertical relationship
+    Real thisY = geometry.centroid.y();
+    Real otherY = other.geometry.centroid.y();
 
-double Polygon::getTotalMass() const {
-    double mass = 0.0;
-    for (const auto& p : particles)
-        mass += p->m;
-    return mass;
+    // Only apply if THIS rests on OTHER
+    if (otherY < thisY - 0.01) {
+        Real relVx = meanVelocity.x() - other.meanVelocity.x();
+        Real blend = 0.2; // Tune as needed
+
+        for (int i = b; i < e; ++i)
+            if (S.w[i] > 0.0)
+                S.v[i].x() -= relVx * blend;
+    }
 }
 
-double Polygon::computeEffectiveNormalForce(const std::vector<std::shared_ptr<Polygon>>& others) {
-    double totalMassAbove = getTotalMass();
 
-    for (const auto& other : others) {
-        if (other.get() != this && other->isAbove(shared_from_this())) {
-            totalMassAbove += other->getTotalMass();
-        }
-    }
 
-    return totalMassAbove * 9.8;
+Real Polygon::getTotalMass() const {
+    return geometry.invMass > 0.0 ? 1.0 / geometry.invMass : 0.0;
 }
 
+void Polygon::updateVelocities(Real timeStep) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
+    if (mode == BodyMode::Rigid) {
+        rigid.velocity = (rigid.position - rigid.previousPosition) / timeStep;
+        rigid.angularVelocity = (rigid.angle - rigid.previousAngle) / timeStep;
 
-void Polygon::updateVelocities(double timeStep) {
-    for (auto& p : particles) {
-        if (!p->fixed) {
-            p->v = (p->x - p->p) / timeStep;
-        }
-        if (!p->fixed && std::abs(p->v.x()) < 0.02 && std::abs(p->v.y()) < 0.01) {
-            p->v.x() = 0;
+        // Particles carry the rigid velocity field for friction and tools
+        for (int i = b; i < e; ++i) {
+            Vec2 r = S.x[i] - rigid.position;
+            S.v[i] = rigid.velocity + rigid.angularVelocity * Vec2(-r.y(), r.x());
         }
+        return;
     }
 
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0) {
+            S.v[i] = (S.x[i] - S.p[i]) / timeStep;
+        }
+    }
+}
 
-    const double linearThreshold = 0.1;
+void Polygon::snapSmallVelocities() {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-    for (auto& p : particles) {
-        if (!p->fixed && p->v.norm() < linearThreshold) {
-            p->v = Vector3d::Zero();
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0 && std::abs(S.v[i].x()) < 0.02 && std::abs(S.v[i].y()) < 0.01) {
+            S.v[i].x() = 0;
         }
     }
 
 
+    const Real linearThreshold = 0.1;
 
-
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0 && S.v[i].norm() < linearThreshold) {
+            S.v[i] = Vec2::Zero();
+        }
+    }
 }
 
-void Polygon::applyGroundFriction(double groundY, const Vector3d& gravity, double timeStep, std::vector<std::shared_ptr<Polygon>> others) {
-    double mu = 0.8;
+void Polygon::applyGroundFriction(Real groundY, Real normalForce, Real timeStep) {
+    Real mu = 0.8;
 
-    // Compute total downward force on the polygon
-    double totalMass = getTotalMass();
-    double normalForce = computeEffectiveNormalForce(others);
-    double maxFriction = mu * normalForce * timeStep;
+    // normalForce is what the polygon presses onto the ground: its own
+    // weight plus the load the world propagated down to it
+    Real maxFriction = mu * normalForce * timeStep;
 
     // Identify how many particles are in contact with the ground
-    std::vector<std::shared_ptr<Particle>> groundParticles;
-    for (auto& p : particles) {
-        if (!p->fixed && std::abs(p->x.y() - groundY) < 1e-4) {
-            groundParticles.push_back(p);
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
+
+    ScratchVector<int> groundParticles;
+    groundParticles.reserve(numParticles());
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0 && std::abs(S.x[i].y() - groundY) < 1e-4) {
+            groundParticles.push_back(i);
         }
     }
 
     if (groundParticles.empty()) return;
 
     // Distribute max friction across grounded particles
-    double frictionPerParticle = maxFriction / groundParticles.size();
+    Real frictionPerParticle = maxFriction / groundParticles.size();
 
-    for (auto& p : groundParticles) {
-        double vx = p->v.x();
+    for (int i : groundParticles) {
+        Real vx = S.v[i].x();
         if (std::abs(vx) > 1e-4) {
-            double friction = std::clamp(-vx, -frictionPerParticle, frictionPerParticle);
-            p->v.x() += friction;
+            Real friction = std::clamp(-vx, -frictionPerParticle, frictionPerParticle);
+            S.v[i].x() += friction;
         }
     }
 }
 
 
 
-void Polygon::step(
-    double timeStep,
-    int springIters,
-    int collisionIters,
-    double groundY,
-    const std::vector<std::shared_ptr<Polygon>>& others,
-    const Vector3d& gravity,
-    double damping)
-{
-    // 1. Apply forces (update velocity only)
-    applyForces(timeStep, gravity, damping);
-
-    // 2. Integrate velocity into position
-    integratePosition(timeStep);
-
-    // 2. Resolve overlaps
-    for (int k = 0; k < collisionIters; ++k) {
-        for (auto& other : others) {
-            if (this < other.get()) {
-                resolveCollisionsWith(other, timeStep);
-            }
-        }
+void Polygon::solveShape(int iterations, Real timeStep) {
+    if (mode == BodyMode::ShapeMatched) {
+        // One closed-form pass per iteration, O(particles)
+        for (int k = 0; k < iterations; ++k) matchShape(timeStep);
+        return;
     }
+    springs.solve(*store, particleBegin(), iterations, timeStep);
+}
 
-    // 3. Satisfy spring constraints
-    for (int k = 0; k < springIters; ++k) {
-        for (auto& s : springs) {
-            Vector3d delta = s->p1->x - s->p0->x;
-            double dist = delta.norm();
-
-            // Prevent divide by zero
-            if (dist < 1e-6) continue;
-
-            // Relative correction
-            double diff = (dist - s->L) / dist;
-
-            // Apply spring correction
-            if (!s->p0->fixed && !s->p1->fixed) {
-                Vector3d correction = 0.5 * diff * delta;
-                s->p0->x += correction;
-                s->p1->x -= correction;
+void Polygon::clampToGround(Real groundY) {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
+
+    if (mode == BodyMode::Rigid) {
+        // Lift the corners below the ground as one body, so the polygon
+        // turns onto its face instead of being squashed. The corners are
+        // solved together, like the points of a contact manifold, and hold
+        // on to the ground as far as friction allows.
+        const Real mu = 0.8;
+        const Vec2 up(0.0, 1.0), along(1.0, 0.0);
+        Vec2 centroid = rigid.position;
+        // One entry per corner that has gone below the ground, with the
+        // impulses accumulated on it over the passes
+        struct GroundCorner {
+            int index;
+            Real normal;
+            Real tangent;
+            Vec2 point;
+            Real lambda;
+        };
+        ScratchVector<GroundCorner> corners;
+        corners.reserve(numParticles());
+        for (int pass = 0; pass < 4; ++pass) {
+            for (int i = b; i < e; ++i) {
+                if (S.x[i].y() >= groundY) continue;
+                bool known = false;
+                for (const GroundCorner& c : corners) known = known || c.index == i;
+                if (!known) corners.push_back({ i, 0.0, 0.0, Vec2::Zero(), 0.0 });
+            }
+            if (corners.empty()) break;
+            const Real count = (Real)corners.size();
+
+            for (GroundCorner& c : corners) {
+                c.point = S.x[c.index];
+                Real w = contactInverseMass(c.point, up, centroid);
+                Real accumulated = w > 1e-8 ? std::max(c.normal + (groundY - c.point.y()) / (w * count), (Real)0.0) : 0.0;
+                c.lambda = accumulated - c.normal;
+                c.normal = accumulated;
             }
-            else if (!s->p0->fixed) {
-                s->p0->x += diff * delta;
+            for (const GroundCorner& c : corners) {
+                applyPositionalImpulse(c.point, c.lambda * up, centroid);
+            }
+
+            for (GroundCorner& c : corners) {
+                c.point = S.x[c.index];
+                Real slip = c.point.x() - S.p[c.index].x();
+                Real w = contactInverseMass(c.point, along, centroid);
+                Real limit = mu * c.normal;
+                Real accumulated = w > 1e-8 ? std::clamp(c.tangent - slip / (w * count), -limit, limit) : 0.0;
+                c.lambda = accumulated - c.tangent;
+                c.tangent = accumulated;
             }
-            else if (!s->p1->fixed) {
-                s->p1->x -= diff * delta;
+            for (const GroundCorner& c : corners) {
+                applyPositionalImpulse(c.point, c.lambda * along, centroid);
             }
         }
-    }
 
-    // 4. Ground collision
-    for (auto& p : particles) {
-        if (!p->fixed && p->x.y() < groundY) {
-            p->x.y() = groundY;
-            if (p->v.y() < 0.0) p->v.y() = 0.0;
+        // Whatever is left is round-off; clamp it like a soft body would
+        for (int i = b; i < e; ++i) {
+            if (S.x[i].y() < groundY) S.x[i].y() = groundY;
         }
+        return;
     }
 
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0 && S.x[i].y() < groundY) {
+            S.x[i].y() = groundY;
+            if (S.v[i].y() < 0.0) S.v[i].y() = 0.0;
+        }
+    }
+}
 
-    // 5. Update velocity
-    updateVelocities(timeStep);
-
-    // 6. Friction
-    applyGroundFriction(groundY, gravity, timeStep, others);
-
-    // 7. Stacking friction
-    applyStackingFriction(others);
+void Polygon::recordMeanVelocity() {
+    const ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
+    meanVelocity = Vec2::Zero();
+    for (int i = b; i < e; ++i) meanVelocity += S.v[i];
+    meanVelocity /= numParticles();
+}
 
+void Polygon::settle() {
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-    Vector3d avgV = Vector3d::Zero();
-    for (auto& p : particles) avgV += p->v;
-    avgV /= particles.size();
+    Vec2 avgV = Vec2::Zero();
+    for (int i = b; i < e; ++i) avgV += S.v[i];
+    avgV /= numParticles();
 
     bool atRest = std::abs(avgV.x()) < 0.01 && std::abs(avgV.y()) < 0.01;
 
-    for (auto& p : particles) {
-        if (p->v.head<2>().norm() > 0.02) {
+    for (int i = b; i < e; ++i) {
+        if (S.v[i].norm() > 0.02) {
             atRest = false;
             break;
         }
     }
 
     if (atRest) {
-        for (auto& p : particles) {
-            if (!p->fixed) {
-                p->v.setZero();
-                p->x.x() = p->p.x();  // full position freeze
+        for (int i = b; i < e; ++i) {
+            if (S.w[i] > 0.0) {
+                S.v[i].setZero();
+                S.x[i].x() = S.p[i].x();  // full position freeze
             }
         }
     }
+}
 
-
+// Feed simulation vectors to GL without converting precision
+static void glVertex2(const Vec2& v) {
+#ifdef SIM_FLOAT
+    glVertex2fv(v.data());
+#else
+    glVertex2dv(v.data());
+#endif
 }
 
 void drawPolygonOffset(
-    const std::vector<std::shared_ptr<Particle>>& particles,
-    float offset,
+    const Vec2* x,
+    int n,
+    Real offset,
     bool fill,
     const Eigen::Vector4f& color,
-    float lineWidth = 2.5f
+    float lineWidth
 ) {
-    using Vec2 = Eigen::Vector2f;
 
     // Compute center of shape
     Vec2 center(0, 0);
-    for (auto& p : particles) {
-        center += Vec2(p->x.x(), p->x.y());
+    for (int i = 0; i < n; ++i) {
+        center += x[i];
     }
-    center /= particles.size();
+    center /= (Real)n;
 
     // Set color
     glColor4f(color.x(), color.y(), color.z(), color.w());
@@ -550,32 +930,34 @@ void drawPolygonOffset(
     }
 
     // Shift and draw
-    for (auto& p : particles) {
-        Vec2 pos(p->x.x(), p->x.y());
-        Vec2 dir = (pos - center).normalized();
-        Vec2 shifted = pos + dir * offset;
-        glVertex2f(shifted.x(), shifted.y());
+    for (int i = 0; i < n; ++i) {
+        Vec2 dir = (x[i] - center).normalized();
+        glVertex2(x[i] + dir * offset);
     }
 
     glEnd();
 }
 
-bool Polygon::containsPoint(const Eigen::Vector2f& point, float extraOffset) const {
-    using Vec2 = Eigen::Vector2f;
+bool Polygon::containsPoint(const Vec2& point, Real extraOffset) const {
+    // Cheap rejection against the cached bounds before ray casting
+    if ((point.array() < geometry.aabbMin.array() - extraOffset).any() ||
+        (point.array() > geometry.aabbMax.array() + extraOffset).any()) {
+        return false;
+    }
+
+    const ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
     // Get center
-    Vec2 center(0, 0);
-    for (auto& p : particles) {
-        center += Vec2(p->x.x(), p->x.y());
-    }
-    center /= particles.size();
+    Vec2 center = geometry.centroid;
 
     // Compute shifted polygon with same offset used in drawPolygonOffset
-    vector<Vec2> shifted;
-    float offset = extraOffset;
+    ScratchVector<Vec2> shifted;
+    shifted.reserve(numParticles());
+    Real offset = extraOffset;
 
-    for (auto& p : particles) {
-        Vec2 pos(p->x.x(), p->x.y());
+    for (int i = b; i < e; ++i) {
+        const Vec2& pos = S.x[i];
         Vec2 dir = (pos - center).normalized();
         shifted.push_back(pos + dir * offset);
     }
@@ -596,84 +978,23 @@ bool Polygon::containsPoint(const Eigen::Vector2f& point, float extraOffset) con
     return inside;
 }
 
-float Polygon::getBoundingRadius() const {
-    Eigen::Vector2f center = getCenter();
-    float maxDistSq = 0.0f;
-
-    for (const auto& p : particles) {
-        Eigen::Vector2f pos(p->x.x(), p->x.y());
-        float distSq = (pos - center).squaredNorm(); // more efficient than .norm()
-        if (distSq > maxDistSq) {
-            maxDistSq = distSq;
-        }
-    }
-
-    return std::sqrt(maxDistSq);
+Real Polygon::getBoundingRadius() const {
+    return geometry.boundingRadius;
 }
 
 
 
-void Polygon::applyImpulseAt(const Eigen::Vector2f& worldPoint, const Eigen::Vector2f& impulse2D) {
-    for (auto& p : particles) {
-        if (!p->fixed) {
-            Eigen::Vector2f pos2D(p->x.x(), p->x.y());
-            float distance = (pos2D - worldPoint).norm();
-            float weight = 1.0f / (1.0f + distance); // Inverse distance weighting
+void Polygon::applyImpulseAt(const Vec2& worldPoint, const Vec2& impulse2D) {
+    wake();
+    ParticleStore& S = *store;
+    const int b = particleBegin(), e = b + numParticles();
 
-            Eigen::Vector3d impulse3D(impulse2D.x(), impulse2D.y(), 0.0);
-            p->v += weight * impulse3D / p->m;
-        }
-    }
-}
+    for (int i = b; i < e; ++i) {
+        if (S.w[i] > 0.0) {
+            Real distance = (S.x[i] - worldPoint).norm();
+            Real weight = 1.0 / (1.0 + distance); // Inverse distance weighting
 
-void Polygon::draw(bool drawParticles, bool drawSprings, bool drawEdges) const {
-
-    // particles
-    if (drawParticles) {
-        glPointSize(5.0f);
-        glBegin(GL_POINTS);
-        glColor3f(1, 0, 0);
-        for (auto& p : particles) {
-            glVertex2f((float)p->x.x(), (float)p->x.y());
+            S.v[i] += weight * impulse2D * S.w[i];
         }
-        glEnd();
     }
-
-    // springs
-    if (drawSprings) {
-        glLineWidth(1);
-        glBegin(GL_LINES);
-        glColor3f(0, 1, 0);
-        for (auto& s : springs) {
-            glVertex2f((float)s->p0->x.x(), (float)s->p0->x.y());
-            glVertex2f((float)s->p1->x.x(), (float)s->p1->x.y());
-        }
-        glEnd();
-    }
-
-    // edges
-    if (drawEdges) {
-        glLineWidth(1);
-        glBegin(GL_LINES);
-        glColor3f(0.0f, 0.5f, 1.0f);
-        for (auto& e : edges) {
-            glVertex2f(e.p0->x.x(), e.p0->x.y());
-            glVertex2f(e.p1->x.x(), e.p1->x.y());
-        }
-        glEnd();
-    }
-
-    // Approximate size
-    float totalLen = 0;
-    for (size_t i = 0; i < particles.size(); ++i) {
-        const auto& a = particles[i]->x;
-        const auto& b = particles[(i + 1) % particles.size()]->x;
-        totalLen += (a - b).head<2>().norm(); // 2D length
-    }
-    float avgLen = totalLen / particles.size();
-    float offset = .5 * .1;
-
-
-    drawPolygonOffset(particles, 0, true, fillColor);
-    drawPolygonOffset(particles, 0, false, outlineColor);
 }
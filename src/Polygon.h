@@ -2,59 +2,167 @@
 #ifndef POLYGON_H
 #define POLYGON_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <Eigen/Dense>
 
-class Particle;
-class Spring;
+#include "SimTypes.h"
+#include "Spring.h"
 
+class ContactCache;
+
+// Geometry derived from particle positions, refreshed once per substep
+// by updateGeometry() and shared by collision, friction, culling and picking
+struct PolygonGeometry {
+    std::vector<Real> nx;  // unit edge normals, x components
+    std::vector<Real> ny;  // unit edge normals, y components
+    Vec2 centroid = Vec2::Zero();
+    Vec2 aabbMin = Vec2::Zero();
+    Vec2 aabbMax = Vec2::Zero();
+    Real boundingRadius = 0.0;
+    Real invMass = 0.0;
+    Real invInertia = 0.0;  // about the centroid, treating the particles as rigid
+    Real maxSpeed = 0.0;    // fastest particle, for how far the polygon can reach in a step
+};
+
+// How a polygon holds its shape
+enum class BodyMode {
+    Springs,  // particle soft body held together by a spring network
+    Rigid,    // a single rigid transform; the particles only mirror it
+    ShapeMatched,  // soft body pulled toward the best-fit pose of its rest shape
+};
+
+// State of a rigid-mode polygon. Particle i sits at
+// position + rotation(angle) * restShape[i].
+struct RigidState {
+    Vec2 position = Vec2::Zero();
+    Vec2 previousPosition = Vec2::Zero();  // at the start of the substep
+    Vec2 velocity = Vec2::Zero();
+    Real angle = 0.0;
+    Real previousAngle = 0.0;
+    Real angularVelocity = 0.0;
+};
+
+// Indices into the owning polygon's particle range
 struct Edge {
-    std::shared_ptr<Particle> p0;
-    std::shared_ptr<Particle> p1;
+    int i0;
+    int i1;
 };
 
 class Polygon : public std::enable_shared_from_this<Polygon> {
 public:
-    Polygon(const Eigen::Vector3d& pos, int numEdges, double width, double height, double rotation = 0.0);
+    // Compliance (inverse stiffness) of a spring-mode polygon's springs.
+    // Particles weigh 1, so a spring pushed 1 unit off its rest length
+    // pulls back with 1 / compliance.
+    static constexpr Real defaultSpringCompliance = 1e-5;
+
+    Polygon(const Vec2& pos, int numEdges, Real width, Real height, Real rotation = 0.0,
+        BodyMode mode = BodyMode::Springs, Real springCompliance = defaultSpringCompliance);
     Polygon(const Polygon& other);  // deep copy
-    void applyForces(double timeStep, const Eigen::Vector3d& gravity, double damping);
-    void resolveCollisionsWith(const std::shared_ptr<Polygon>& other, double timeStep);
-    void updateVelocities(double timeStep);
-    double getTotalMass() const;
-    double computeEffectiveNormalForce(const std::vector<std::shared_ptr<Polygon>>& others);
-    void integratePosition(double timeStep);
-	void applyStackingFriction(const std::vector<std::shared_ptr<Polygon>>& others);
-    bool isTouching(const std::shared_ptr<Polygon>& other) const;
-    float getBoundingRadius() const;
-    void moveCenterTo(const Eigen::Vector3d& target);
-    void applyGroundFriction(double groundY, const Eigen::Vector3d& gravity, double timeStep, std::vector<std::shared_ptr<Polygon>> others);
-    void step(
-        double timeStep,
-        int springIters,
-        int collisionIters,
-        double groundY,
-        const std::vector<std::shared_ptr<Polygon>>& others,
-        const Eigen::Vector3d& gravity,
-        double damping
-    );
-    void draw(bool drawParticles = false, bool drawSprings = false, bool drawEdges = false) const;
-    bool containsPoint(const Eigen::Vector2f& point, float extraOffset = 0.0f) const;
-    bool isAbove(const std::shared_ptr<Polygon>& other) const;
-    void applyImpulseAt(const Eigen::Vector2f& worldPoint, const Eigen::Vector2f& impulse2D);
-    Eigen::Vector2f getCenter() const;
+    Polygon& operator=(const Polygon&) = delete;
+    ~Polygon();
+    void applyForces(Real timeStep, const Vec2& gravity, Real damping);
+    // Pairs with at least gjkMinVertices vertices between them are tested
+    // with GJK/EPA rather than SAT, see World::gjkMinVertices
+    void resolveCollisionsWith(const std::shared_ptr<Polygon>& other, Real timeStep, ContactCache& contacts,
+        int gjkMinVertices);
+    void updateVelocities(Real timeStep);
+    void snapSmallVelocities();  // once per frame, after the last substep
+    Real getTotalMass() const;
+    void integratePosition(Real timeStep);
+    // Slows this polygon toward a polygon it touches, if it rests on it,
+    // using the velocities both had at their last recordMeanVelocity()
+	void applyStackingFriction(const Polygon& other);
+    Real getBoundingRadius() const;
+    void moveCenterTo(const Vec2& target);
+    void applyGroundFriction(Real groundY, Real normalForce, Real timeStep);
+    // Phases of World::step. Each touches only this polygon's particles, so
+    // the world can run one phase over every polygon at once
+    void solveShape(int iterations, Real timeStep);  // springs or shape matching
+    void clampToGround(Real groundY);
+    void recordMeanVelocity();
+    const Vec2& getMeanVelocity() const { return meanVelocity; }
+    void settle();  // freeze a polygon that has all but stopped
+    bool containsPoint(const Vec2& point, Real extraOffset = 0.0) const;
+    void applyImpulseAt(const Vec2& worldPoint, const Vec2& impulse2D);
+    Vec2 getCenter() const;
+    // Corner i of the shape the constructor builds from these arguments
+    static Vec2 regularCorner(const Vec2& center, int i, int numEdges, Real width, Real height, Real rotation);
+    void updateGeometry();
+    const PolygonGeometry& getGeometry() const { return geometry; }
+
+    BodyMode getMode() const { return mode; }
+
+    // Unique for the lifetime of the program; copies get a fresh id
+    int getId() const { return id; }
+
+    // Sleeping polygons are frozen and skipped by the world until woken
+    bool isSleeping() const { return sleeping; }
+    void wake();
+    void sleep();
+    // Seconds the polygon has moved slower than quietSpeed, counting this step
+    Real updateSleepTimer(Real timeStep, Real quietSpeed);
+
+    // Folds everything this polygon carries over to the next step into hash
+    // (FNV-1a over the raw bits), so equal hashes mean bitwise equal states.
+    // What the world keeps about pairs is hashed by World::stateHash().
+    uint64_t hashState(uint64_t hash) const;
     Eigen::Vector4f defaultOutlineColor = Eigen::Vector4f(1.0f, 1.0f, 1.0f, 1.0f);
     Eigen::Vector4f defaultFillColor = Eigen::Vector4f(0.1f, 0.1f, 0.1f, 1.0f);
     Eigen::Vector4f outlineColor = defaultOutlineColor;
     Eigen::Vector4f fillColor = defaultFillColor;
-    std::vector<std::shared_ptr<Particle>> particles;
-    std::vector<std::shared_ptr<Spring>> springs;
+    SpringSet springs;
+
+    // Particles live in a shared structure-of-arrays store; this polygon owns
+    // the contiguous range [particleBegin(), particleBegin() + numParticles())
+    int particleBegin() const;
+    int numParticles() const;
+    const Vec2& particlePosition(int i) const;
 
 private:
+    std::shared_ptr<ParticleStore> store;
+    int handle;
+    int id;
+    BodyMode mode;
+    RigidState rigid;
     std::vector<Edge> edges;
-    double collisionThickness = 0.08;
+    PolygonGeometry geometry;
+    Real collisionThickness = 0.08;
+    Real speculativeFraction = 0.25;  // pairs closing more than this share of the smaller radius per substep get speculative contacts
+    Real shapeCompliance = 1e-5;  // inverse stiffness of the pull toward the matched shape
+    std::vector<Vec2> restShape;  // corners relative to the centroid as built
+    bool sleeping = false;
+    Real sleepTimer = 0.0;
+    Vec2 meanVelocity = Vec2::Zero();
+    Vec2 sleepCentroid = Vec2::Zero();  // where updateSleepTimer last saw us
+    Vec2 sleepCorner = Vec2::Zero();
 
-    void generateRegularPolygon(const Eigen::Vector3d& center, int numEdges, double width, double height, double rotation);
+    void generateRegularPolygon(const Vec2& center, int numEdges, Real width, Real height, Real rotation,
+        Real springCompliance);
+
+    // Rigid-body view of the particles used by the contact solver. The
+    // centroid is passed in so a pair can track it while it solves.
+    Vec2 liveCentroid() const;
+    Real contactInverseMass(const Vec2& point, const Vec2& dir, const Vec2& centroid) const;
+    void applyPositionalImpulse(const Vec2& point, const Vec2& impulse, Vec2& centroid);
+
+    // Rigid mode. Tools and friction act on the particles, so the rigid
+    // state is re-read from them (best-fit pose, momentum) before each
+    // substep; within a substep the rigid state leads and the particles
+    // are placed from it.
+    void readRigidState();
+    void placeRigidParticles();
+
+    // Angle of the rest shape that best fits the particles about center,
+    // found as a correction to the given angle
+    Real bestFitAngle(const Vec2& center, Real angle) const;
+    void matchShape(Real timeStep);
 };
 
+// Draws the closed shape through x, filled or as an outline, with every
+// corner pushed offset away from the center
+void drawPolygonOffset(const Vec2* x, int n, Real offset, bool fill, const Eigen::Vector4f& color,
+    float lineWidth = 2.5f);
+
 #endif
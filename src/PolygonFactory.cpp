@@ -9,52 +9,55 @@ using namespace std;
 using namespace Eigen;
 
 shared_ptr<Polygon> PolygonFactory::CreateRectangle(
-    const Vector3d& pos, double width, double height
+    const Vec2& pos, Real width, Real height, BodyMode mode, Real springCompliance
 ) {
-    double rotation = M_PI / 4.0;
-    return make_shared<Polygon>(pos, 4, width, height, rotation);
+    Real rotation = M_PI / 4.0;
+    return make_shared<Polygon>(pos, 4, width, height, rotation, mode, springCompliance);
 }
 
 shared_ptr<Polygon> PolygonFactory::CreateRegularPolygon(
-    const Vector3d& pos, int numEdges, double width, double height, double rotation
+    const Vec2& pos, int numEdges, Real width, Real height, Real rotation, BodyMode mode,
+    Real springCompliance
 ) {
-    return make_shared<Polygon>(pos, numEdges, width, height, rotation);
+    return make_shared<Polygon>(pos, numEdges, width, height, rotation, mode, springCompliance);
 }
 
 vector<shared_ptr<Polygon>> PolygonFactory::CreateStackedRectangles(
-    const Vector3d& basePos, int count, double width, double height, double spacing
+    const Vec2& basePos, int count, Real width, Real height, Real spacing, BodyMode mode,
+    Real springCompliance
 ) {
     vector<shared_ptr<Polygon>> polys;
     for (int i = 0; i < count; ++i) {
-        Vector3d pos = basePos + Vector3d(0, i * (height + spacing), 0);
-        polys.push_back(CreateRectangle(pos, width, height));
+        Vec2 pos = basePos + Vec2(0, i * (height + spacing));
+        polys.push_back(CreateRectangle(pos, width, height, mode, springCompliance));
     }
     return polys;
 }
 
 vector<shared_ptr<Polygon>> PolygonFactory::CreateWall(
-    const Vector3d& basePos, int rows, int cols, double width, double height, double spacing
+    const Vec2& basePos, int rows, int cols, Real width, Real height, Real spacing, BodyMode mode,
+    Real springCompliance
 ) {
     vector<shared_ptr<Polygon>> polys;
     for (int i = 0; i < rows; ++i) {
         for (int j = 0; j < cols; ++j) {
-            Vector3d pos = basePos +
-                Vector3d(j * (width + spacing), i * (height + spacing), 0);
-            polys.push_back(CreateRectangle(pos, width, height));
+            Vec2 pos = basePos +
+                Vec2(j * (width + spacing), i * (height + spacing));
+            polys.push_back(CreateRectangle(pos, width, height, mode, springCompliance));
         }
     }
     return polys;
 }
 
 vector<shared_ptr<Polygon>> PolygonFactory::CreateGridOfPolygons(
-    const Vector3d& basePos, int rows, int cols, int numEdges,
-    double width, double height, double spacingX, double spacingY
+    const Vec2& basePos, int rows, int cols, int numEdges,
+    Real width, Real height, Real spacingX, Real spacingY, BodyMode mode, Real springCompliance
 ) {
     vector<shared_ptr<Polygon>> polys;
     for (int i = 0; i < rows; ++i) {
         for (int j = 0; j < cols; ++j) {
-            Vector3d pos = basePos + Vector3d(j * (width + spacingX), i * (height + spacingY), 0);
-            polys.push_back(CreateRegularPolygon(pos, numEdges, width, height));
+            Vec2 pos = basePos + Vec2(j * (width + spacingX), i * (height + spacingY));
+            polys.push_back(CreateRegularPolygon(pos, numEdges, width, height, 0.0, mode, springCompliance));
         }
     }
     return polys;
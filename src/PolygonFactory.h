@@ -5,47 +5,60 @@
 #include <Eigen/Dense>
 #include "Polygon.h"
 
+// Every factory takes a BodyMode; BodyMode::Rigid polygons skip the spring
+// network and are much cheaper in big walls and piles. springCompliance
+// only matters to BodyMode::Springs, see Polygon::defaultSpringCompliance.
 class PolygonFactory {
 public:
     static std::shared_ptr<Polygon> CreateRectangle(
-        const Eigen::Vector3d& pos,
-        double width,
-        double height
+        const Vec2& pos,
+        Real width,
+        Real height,
+        BodyMode mode = BodyMode::Springs,
+        Real springCompliance = Polygon::defaultSpringCompliance
     );
 
     static std::shared_ptr<Polygon> CreateRegularPolygon(
-        const Eigen::Vector3d& pos,
+        const Vec2& pos,
         int numEdges,
-        double width,
-        double height,
-        double rotation = 0.0
+        Real width,
+        Real height,
+        Real rotation = 0.0,
+        BodyMode mode = BodyMode::Springs,
+        Real springCompliance = Polygon::defaultSpringCompliance
     );
 
     static std::vector<std::shared_ptr<Polygon>> CreateStackedRectangles(
-        const Eigen::Vector3d& basePos,
+        const Vec2& basePos,
         int count,
-        double width,
-        double height,
-        double spacing = 0.0
+        Real width,
+        Real height,
+        Real spacing = 0.0,
+        BodyMode mode = BodyMode::Springs,
+        Real springCompliance = Polygon::defaultSpringCompliance
     );
 
     static std::vector<std::shared_ptr<Polygon>> CreateWall(
-        const Eigen::Vector3d& basePos,
+        const Vec2& basePos,
         int rows,
         int cols,
-        double width,
-        double height,
-        double spacing = 0.0
+        Real width,
+        Real height,
+        Real spacing = 0.0,
+        BodyMode mode = BodyMode::Springs,
+        Real springCompliance = Polygon::defaultSpringCompliance
     );
 
     static std::vector<std::shared_ptr<Polygon>> CreateGridOfPolygons(
-        const Eigen::Vector3d& basePos,
+        const Vec2& basePos,
         int rows,
         int cols,
         int numEdges,
-        double width,
-        double height,
-        double spacingX = 0.0,
-        double spacingY = 0.0
+        Real width,
+        Real height,
+        Real spacingX = 0.0,
+        Real spacingY = 0.0,
+        BodyMode mode = BodyMode::Springs,
+        Real springCompliance = Polygon::defaultSpringCompliance
     );
 };
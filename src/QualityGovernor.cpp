@@ -0,0 +1,107 @@
+#include "QualityGovernor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+// Cheapest first; each level costs noticeably more than the one before and
+// is at least as stable. Spring bodies need substeps more than contact
+// iterations, so the ladder adds substeps first. Below 3 substeps a 10-box
+// spring tower falls over, so no level goes there; a 20x10 spring wall
+// stands from 6x1 up.
+const QualityGovernor::Level QualityGovernor::levels[] = {
+    { 3, 1 },
+    { 4, 1 },
+    { 6, 1 },
+    { 8, 1 },
+    { 8, 2 },
+};
+const int QualityGovernor::numLevels = sizeof(levels) / sizeof(levels[0]);
+
+// Where the governor starts, and stays while held
+static const int startLevel = 2;
+
+// Steps to wait after a change before trusting the averages again
+static const int settleSteps = 10;
+static const double smoothing = 0.1;
+
+QualityGovernor::QualityGovernor(double budgetMs)
+    : budgetMs(budgetMs),
+    level(startLevel)
+{
+}
+
+double QualityGovernor::cost(const Level& l) {
+    // Integration, springs and the manifold build run once per substep,
+    // the contact sweep once per iteration of each substep
+    return l.substeps * (1.0 + l.collisionIters);
+}
+
+int QualityGovernor::substeps() const {
+    return levels[level].substeps;
+}
+
+int QualityGovernor::collisionIters() const {
+    return levels[level].collisionIters;
+}
+
+void QualityGovernor::hold(bool on) {
+    held = on;
+    if (held && level != startLevel) {
+        level = startLevel;
+        stepMs = unitMs * cost(levels[level]);
+        stepsAtLevel = 0;
+    }
+}
+
+void QualityGovernor::record(double step) {
+    double unit = step / cost(levels[level]);
+
+    if (unitMs == 0.0) {
+        stepMs = step;
+        unitMs = unit;
+    }
+    else {
+        stepMs += smoothing * (step - stepMs);
+        unitMs += smoothing * (unit - unitMs);
+    }
+
+    if (++stepsAtLevel < settleSteps || held) return;
+
+    auto predicted = [&](int l) { return unitMs * cost(levels[l]); };
+
+    int next = level;
+    if (predicted(level) > budgetMs) {
+        // Over budget: drop straight to the best level that fits
+        while (next > 0 && predicted(next) > budgetMs) --next;
+    }
+    else if (level + 1 < numLevels && predicted(level + 1) < budgetMs * headroom) {
+        ++next;
+    }
+
+    if (next != level) {
+        // The step cost just changed scale; keep the per-unit estimate but
+        // let the step average start over from it
+        level = next;
+        stepMs = unitMs * cost(levels[level]);
+        stepsAtLevel = 0;
+    }
+}
+
+QualityGovernor::Report QualityGovernor::report() const {
+    Report r;
+    r.substeps = substeps();
+    r.collisionIters = collisionIters();
+    r.held = held;
+    r.stepMs = averageStepMs();
+    r.budgetMs = budgetMs;
+    return r;
+}
+
+string QualityGovernor::describe(const Report& report) {
+    char text[96];
+    snprintf(text, sizeof(text), "%d substeps x %d iters%s, %.1f/%.1f ms",
+        report.substeps, report.collisionIters, report.held ? " (held)" : "", report.stepMs, report.budgetMs);
+    return text;
+}
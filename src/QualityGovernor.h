@@ -0,0 +1,69 @@
+#pragma once
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+#include <string>
+
+// Picks how many solver substeps and contact iterations the world can afford.
+// After every step it is told what World::step cost; it keeps a running
+// average of that cost per unit of solver work and moves to the best quality
+// level whose predicted step time fits the budget. It steps down as soon as
+// the budget is missed and climbs one level at a time with some headroom, so
+// quality degrades smoothly with load and does not flicker between two
+// levels. Each level is at least as stable as the ones below it, so spare
+// budget never makes a scene worse.
+class QualityGovernor {
+public:
+    // budgetMs is what one step may take. The simulation thread must finish
+    // a step within the step's own length to keep up with real time.
+    explicit QualityGovernor(double budgetMs = 1000.0 / 60.0);
+
+    // Milliseconds the last World::step took
+    void record(double stepMs);
+
+    int substeps() const;
+    int collisionIters() const;
+
+    // While held, the governor stays at its starting level whatever the
+    // cost, so a run does not depend on how fast the machine was. Used by
+    // the deterministic mode.
+    void hold(bool on);
+    bool isHeld() const { return held; }
+
+    double averageStepMs() const { return stepMs; }
+
+    // What the governor settled on, as plain values that can be copied
+    // into a render snapshot without allocating
+    struct Report {
+        int substeps = 0;
+        int collisionIters = 0;
+        bool held = false;
+        double stepMs = 0.0;
+        double budgetMs = 0.0;
+    };
+    Report report() const;
+
+    // e.g. "4 substeps x 2 iters, 3.1/16.7 ms"
+    static std::string describe(const Report& report);
+
+    double budgetMs;
+    double headroom = 0.8;  // share of the budget a level must fit in before we climb to it
+
+private:
+    struct Level {
+        int substeps;
+        int collisionIters;
+    };
+    static const Level levels[];
+    static const int numLevels;
+
+    static double cost(const Level& level);
+
+    int level;
+    double stepMs = 0.0;   // averages; exponential so old steps fade out
+    double unitMs = 0.0;   // step cost per unit of cost()
+    int stepsAtLevel = 0;
+    bool held = false;
+};
+
+#endif
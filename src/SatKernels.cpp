@@ -0,0 +1,300 @@
+#include "SatKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Leftover axes, and whole targets without SIMD
+template <typename Scalar>
+static void projectScalar(const Vec2T<Scalar>* x, int n,
+    const Scalar* axX, const Scalar* axY, int first, int numAxes,
+    Scalar* mins, Scalar* maxs)
+{
+    for (int k = first; k < numAxes; ++k) {
+        Scalar lo = numeric_limits<Scalar>::infinity();
+        Scalar hi = -numeric_limits<Scalar>::infinity();
+        for (int i = 0; i < n; ++i) {
+            Scalar d = x[i].x() * axX[k] + x[i].y() * axY[k];
+            lo = std::min(lo, d);
+            hi = std::max(hi, d);
+        }
+        mins[k] = lo;
+        maxs[k] = hi;
+    }
+}
+
+void projectOntoAxes(const Vec2T<float>* x, int n,
+    const float* axX, const float* axY, int numAxes,
+    float* mins, float* maxs)
+{
+    int k = 0;
+    const float inf = numeric_limits<float>::infinity();
+
+#if defined(__AVX__)
+    for (; k + 8 <= numAxes; k += 8) {
+        __m256 ax = _mm256_loadu_ps(axX + k);
+        __m256 ay = _mm256_loadu_ps(axY + k);
+        __m256 lo = _mm256_set1_ps(inf);
+        __m256 hi = _mm256_set1_ps(-inf);
+        for (int i = 0; i < n; ++i) {
+            __m256 d = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(x[i].x()), ax),
+                _mm256_mul_ps(_mm256_set1_ps(x[i].y()), ay));
+            lo = _mm256_min_ps(lo, d);
+            hi = _mm256_max_ps(hi, d);
+        }
+        _mm256_storeu_ps(mins + k, lo);
+        _mm256_storeu_ps(maxs + k, hi);
+    }
+#endif
+
+#if defined(__SSE2__)
+    for (; k + 4 <= numAxes; k += 4) {
+        __m128 ax = _mm_loadu_ps(axX + k);
+        __m128 ay = _mm_loadu_ps(axY + k);
+        __m128 lo = _mm_set1_ps(inf);
+        __m128 hi = _mm_set1_ps(-inf);
+        for (int i = 0; i < n; ++i) {
+            __m128 d = _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(x[i].x()), ax),
+                _mm_mul_ps(_mm_set1_ps(x[i].y()), ay));
+            lo = _mm_min_ps(lo, d);
+            hi = _mm_max_ps(hi, d);
+        }
+        _mm_storeu_ps(mins + k, lo);
+        _mm_storeu_ps(maxs + k, hi);
+    }
+#endif
+
+    projectScalar(x, n, axX, axY, k, numAxes, mins, maxs);
+}
+
+void projectOntoAxes(const Vec2T<double>* x, int n,
+    const double* axX, const double* axY, int numAxes,
+    double* mins, double* maxs)
+{
+    int k = 0;
+    const double inf = numeric_limits<double>::infinity();
+
+#if defined(__AVX__)
+    for (; k + 4 <= numAxes; k += 4) {
+        __m256d ax = _mm256_loadu_pd(axX + k);
+        __m256d ay = _mm256_loadu_pd(axY + k);
+        __m256d lo = _mm256_set1_pd(inf);
+        __m256d hi = _mm256_set1_pd(-inf);
+        for (int i = 0; i < n; ++i) {
+            __m256d d = _mm256_add_pd(
+                _mm256_mul_pd(_mm256_set1_pd(x[i].x()), ax),
+                _mm256_mul_pd(_mm256_set1_pd(x[i].y()), ay));
+            lo = _mm256_min_pd(lo, d);
+            hi = _mm256_max_pd(hi, d);
+        }
+        _mm256_storeu_pd(mins + k, lo);
+        _mm256_storeu_pd(maxs + k, hi);
+    }
+#endif
+
+#if defined(__SSE2__)
+    for (; k + 2 <= numAxes; k += 2) {
+        __m128d ax = _mm_loadu_pd(axX + k);
+        __m128d ay = _mm_loadu_pd(axY + k);
+        __m128d lo = _mm_set1_pd(inf);
+        __m128d hi = _mm_set1_pd(-inf);
+        for (int i = 0; i < n; ++i) {
+            __m128d d = _mm_add_pd(
+                _mm_mul_pd(_mm_set1_pd(x[i].x()), ax),
+                _mm_mul_pd(_mm_set1_pd(x[i].y()), ay));
+            lo = _mm_min_pd(lo, d);
+            hi = _mm_max_pd(hi, d);
+        }
+        _mm_storeu_pd(mins + k, lo);
+        _mm_storeu_pd(maxs + k, hi);
+    }
+#endif
+
+    projectScalar(x, n, axX, axY, k, numAxes, mins, maxs);
+}
+
+template <typename Scalar>
+int satMinOverlap(const Vec2T<Scalar>* a, int na, const Vec2T<Scalar>* b, int nb,
+    const Scalar* axX, const Scalar* axY, int numAxes, Scalar& depth, Scalar gap,
+    int* separating)
+{
+    // Work through the axes in register-friendly chunks so the scratch
+    // buffers stay on the stack whatever the vertex count
+    const int chunk = 16;
+    Scalar minA[chunk], maxA[chunk], minB[chunk], maxB[chunk];
+
+    int best = -1;
+    depth = numeric_limits<Scalar>::infinity();
+
+    for (int first = 0; first < numAxes; first += chunk) {
+        int count = std::min(chunk, numAxes - first);
+        projectOntoAxes(a, na, axX + first, axY + first, count, minA, maxA);
+        projectOntoAxes(b, nb, axX + first, axY + first, count, minB, maxB);
+
+        for (int k = 0; k < count; ++k) {
+            Scalar overlap = std::min(maxA[k], maxB[k]) - std::max(minA[k], minB[k]);
+            if (overlap < -gap) {
+                // Separating axis -> no collision
+                if (separating) *separating = first + k;
+                return -1;
+            }
+
+            if (overlap < depth) {
+                depth = overlap;
+                best = first + k;
+            }
+        }
+    }
+    return best;
+}
+
+template int satMinOverlap<float>(const Vec2T<float>*, int, const Vec2T<float>*, int,
+    const float*, const float*, int, float&, float, int*);
+template int satMinOverlap<double>(const Vec2T<double>*, int, const Vec2T<double>*, int,
+    const double*, const double*, int, double&, double, int*);
+
+// Index and depth of the smallest of n overlaps, or false, with best set
+// to the separating one, if one of them is below -gap
+template <typename Scalar>
+static bool minOverlap(const Scalar* overlap, int n, Scalar gap, int& best, Scalar& depth) {
+    best = -1;
+    depth = numeric_limits<Scalar>::infinity();
+    for (int k = 0; k < n; ++k) {
+        if (overlap[k] < -gap) {
+            best = k;
+            return false;
+        }
+        if (overlap[k] < depth) {
+            depth = overlap[k];
+            best = k;
+        }
+    }
+    return true;
+}
+
+// Vertices run in the outer loop and axes in the inner one, whose fixed
+// length lets the compiler unroll it and keep several axes in one SIMD
+// register, with no leftover loop
+template <typename Scalar, int NA, int NB>
+static bool satPairFixed(const Vec2T<Scalar>* a, const Scalar* aX, const Scalar* aY,
+    const Vec2T<Scalar>* b, const Scalar* bX, const Scalar* bY,
+    int& bestA, Scalar& depthA, int& bestB, Scalar& depthB, Scalar gap)
+{
+    const int M = NA + NB;
+    Scalar axX[M], axY[M];
+    for (int k = 0; k < NA; ++k) {
+        axX[k] = aX[k];
+        axY[k] = aY[k];
+    }
+    for (int k = 0; k < NB; ++k) {
+        axX[NA + k] = bX[k];
+        axY[NA + k] = bY[k];
+    }
+
+    Scalar minA[M], maxA[M], minB[M], maxB[M];
+    for (int k = 0; k < M; ++k) {
+        minA[k] = maxA[k] = a[0].x() * axX[k] + a[0].y() * axY[k];
+        minB[k] = maxB[k] = b[0].x() * axX[k] + b[0].y() * axY[k];
+    }
+    for (int i = 1; i < NA; ++i) {
+        const Scalar x = a[i].x(), y = a[i].y();
+        // simd came with OpenMP 4.0; MSVC's /openmp is 2.0
+        #if defined(_OPENMP) && _OPENMP >= 201307
+        #pragma omp simd
+        #endif
+        for (int k = 0; k < M; ++k) {
+            Scalar d = x * axX[k] + y * axY[k];
+            minA[k] = d < minA[k] ? d : minA[k];
+            maxA[k] = d > maxA[k] ? d : maxA[k];
+        }
+    }
+    for (int i = 1; i < NB; ++i) {
+        const Scalar x = b[i].x(), y = b[i].y();
+        #if defined(_OPENMP) && _OPENMP >= 201307
+        #pragma omp simd
+        #endif
+        for (int k = 0; k < M; ++k) {
+            Scalar d = x * axX[k] + y * axY[k];
+            minB[k] = d < minB[k] ? d : minB[k];
+            maxB[k] = d > maxB[k] ? d : maxB[k];
+        }
+    }
+
+    Scalar overlap[M];
+    for (int k = 0; k < M; ++k)
+        overlap[k] = std::min(maxA[k], maxB[k]) - std::max(minA[k], minB[k]);
+
+    bestB = -1;
+    if (!minOverlap(overlap, NA, gap, bestA, depthA)) return false;
+    if (!minOverlap(overlap + NA, NB, gap, bestB, depthB)) {
+        bestA = -1;
+        return false;
+    }
+    return true;
+}
+
+template <typename Scalar>
+using SatPairKernel = bool (*)(const Vec2T<Scalar>*, const Scalar*, const Scalar*,
+    const Vec2T<Scalar>*, const Scalar*, const Scalar*,
+    int&, Scalar&, int&, Scalar&, Scalar);
+
+// Kernels for na, nb = minFixed..maxFixed, indexed [na - minFixed][nb - minFixed]
+static const int minFixed = 3;
+static const int maxFixed = 8;
+static const int numFixed = maxFixed - minFixed + 1;
+
+template <typename Scalar>
+using SatPairRow = array<SatPairKernel<Scalar>, numFixed>;
+
+template <typename Scalar, int NA, int... NB>
+static constexpr SatPairRow<Scalar> satPairRow(integer_sequence<int, NB...>) {
+    return {{ &satPairFixed<Scalar, NA, minFixed + NB>... }};
+}
+
+template <typename Scalar, int... NA>
+static constexpr array<SatPairRow<Scalar>, numFixed> satPairTable(integer_sequence<int, NA...>) {
+    return {{ satPairRow<Scalar, minFixed + NA>(make_integer_sequence<int, numFixed>())... }};
+}
+
+template <typename Scalar>
+bool satPair(const Vec2T<Scalar>* a, int na, const Scalar* aX, const Scalar* aY,
+    const Vec2T<Scalar>* b, int nb, const Scalar* bX, const Scalar* bY,
+    int& bestA, Scalar& depthA, int& bestB, Scalar& depthB, Scalar gap)
+{
+    static constexpr array<SatPairRow<Scalar>, numFixed> kernels =
+        satPairTable<Scalar>(make_integer_sequence<int, numFixed>());
+
+    if (na >= minFixed && na <= maxFixed && nb >= minFixed && nb <= maxFixed) {
+        return kernels[na - minFixed][nb - minFixed](a, aX, aY, b, bX, bY,
+            bestA, depthA, bestB, depthB, gap);
+    }
+
+    int separating = -1;
+    bestB = -1;
+    bestA = satMinOverlap(a, na, b, nb, aX, aY, na, depthA, gap, &separating);
+    if (bestA < 0) {
+        bestA = separating;
+        return false;
+    }
+    bestB = satMinOverlap(a, na, b, nb, bX, bY, nb, depthB, gap, &separating);
+    if (bestB < 0) {
+        bestA = -1;
+        bestB = separating;
+        return false;
+    }
+    return true;
+}
+
+template bool satPair<float>(const Vec2T<float>*, int, const float*, const float*,
+    const Vec2T<float>*, int, const float*, const float*, int&, float&, int&, float&, float);
+template bool satPair<double>(const Vec2T<double>*, int, const double*, const double*,
+    const Vec2T<double>*, int, const double*, const double*, int&, double&, int&, double&, double);
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef SATKERNELS_H
+#define SATKERNELS_H
+
+#include "SimTypes.h"
+
+// Separating-axis kernels. Vertices are contiguous Vec2s, exactly as laid out
+// in the particle store. Axes are passed as separate x/y arrays so a SIMD
+// register can hold several of them; every vertex is then projected onto all
+// of those axes at once. AVX and SSE2 paths are picked at compile time, with
+// a scalar fallback for other targets and for leftover axes. The common
+// small polygons get kernels with their vertex counts built in instead.
+
+// mins[k], maxs[k] = extent of the n vertices projected onto axis k
+void projectOntoAxes(const Vec2T<float>* x, int n,
+    const float* axX, const float* axY, int numAxes,
+    float* mins, float* maxs);
+void projectOntoAxes(const Vec2T<double>* x, int n,
+    const double* axX, const double* axY, int numAxes,
+    double* mins, double* maxs);
+
+// Smallest overlap of polygons a and b over the given axes. Returns the index
+// of that axis and stores its overlap in depth, or returns -1 as soon as one
+// of the axes separates the polygons by more than gap (and stores that
+// axis's index in separating, if given). With a gap the depth can come out
+// negative: the polygons are that far apart along the axis.
+template <typename Scalar>
+int satMinOverlap(const Vec2T<Scalar>* a, int na, const Vec2T<Scalar>* b, int nb,
+    const Scalar* axX, const Scalar* axY, int numAxes, Scalar& depth, Scalar gap = 0,
+    int* separating = nullptr);
+
+// The whole test for a pair: satMinOverlap over a's edge normals (aX, aY)
+// into bestA and depthA, then over b's into bestB and depthB. Returns false
+// when an axis separates the polygons by more than gap; the separating axis
+// is then left in bestA or in bestB, and the other is -1. Pairs of 3 to 8
+// vertices each run a kernel compiled for their (na, nb), which projects
+// onto all na + nb axes in one pass with every loop bound fixed; larger
+// polygons take the generic path.
+template <typename Scalar>
+bool satPair(const Vec2T<Scalar>* a, int na, const Scalar* aX, const Scalar* aY,
+    const Vec2T<Scalar>* b, int nb, const Scalar* bX, const Scalar* bY,
+    int& bestA, Scalar& depthA, int& bestB, Scalar& depthB, Scalar gap = 0);
+
+#endif
@@ -0,0 +1,98 @@
+#include "SimThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+SimThread::SimThread(Real timeStep, function<void()> step, function<void(RenderSnapshot&)> snapshot)
+    : timeStep(timeStep),
+    step(std::move(step)),
+    snapshot(std::move(snapshot))
+{
+}
+
+SimThread::~SimThread() {
+    stop();
+}
+
+double SimThread::now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimThread::start() {
+    if (running) return;
+
+    // Publish the state we start from, so there is something to draw
+    RenderSnapshot& first = snapshots.writeSlot();
+    snapshot(first);
+    first.time = now();
+    snapshots.publish();
+
+    running = true;
+    thread = std::thread(&SimThread::run, this);
+}
+
+void SimThread::stop() {
+    if (!running) return;
+    {
+        lock_guard<mutex> lock(commandMutex);
+        running = false;
+    }
+    commandPosted.notify_one();
+    thread.join();
+}
+
+void SimThread::post(Command command) {
+    {
+        lock_guard<mutex> lock(commandMutex);
+        pending.push_back(std::move(command));
+    }
+    commandPosted.notify_one();
+}
+
+const RenderSnapshot& SimThread::latest() {
+    snapshots.fetch();
+    return snapshots.readSlot();
+}
+
+void SimThread::run() {
+    vector<Command> commands;
+    double last = now();
+    double accumulator = 0.0;
+
+    while (running) {
+        // Input first, so it acts on the very next step
+        {
+            lock_guard<mutex> lock(commandMutex);
+            commands.swap(pending);
+        }
+        for (auto& command : commands) command();
+        bool changed = !commands.empty();
+        commands.clear();
+
+        double t = now();
+        accumulator += std::min(t - last, maxStepsPerTick * (double)timeStep);
+        last = t;
+
+        while (accumulator >= timeStep) {
+            step();
+            accumulator -= timeStep;
+            changed = true;
+        }
+
+        if (changed) {
+            // What is left in the accumulator is how far real time has run
+            // past the state we publish
+            RenderSnapshot& s = snapshots.writeSlot();
+            snapshot(s);
+            s.time = t - accumulator;
+            snapshots.publish();
+        }
+
+        // Sleep until the next step is due, or until input arrives
+        unique_lock<mutex> lock(commandMutex);
+        commandPosted.wait_for(lock, chrono::duration<double>(timeStep - accumulator),
+            [&] { return !pending.empty() || !running; });
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "QualityGovernor.h"
+#include "SimTypes.h"
+#include "TripleBuffer.h"
+
+// Everything the render thread needs to draw one simulation state, copied
+// out of the world so drawing never touches a Polygon
+struct RenderSnapshot {
+    struct Shape {
+        int first = 0;  // range in from and to
+        int count = 0;
+        Eigen::Vector4f fillColor;
+        Eigen::Vector4f outlineColor;
+        Vec2 aabbMin = Vec2::Zero();  // at the end of the step, for culling
+        Vec2 aabbMax = Vec2::Zero();
+    };
+
+    std::vector<Vec2> from;  // particle positions when the latest step started
+    std::vector<Vec2> to;    // and when it ended
+    std::vector<Shape> shapes;
+    double time = 0.0;       // SimThread::now() at which `to` was current
+
+    // Tool overlays
+    std::vector<Vec2> lines;  // pairs of end points
+    Eigen::Vector3f lineColor = Eigen::Vector3f::Ones();
+    bool selecting = false;
+    Vec2 selectStart = Vec2::Zero();
+    Vec2 selectEnd = Vec2::Zero();
+
+    int numPolygons = 0;
+    int numSleeping = 0;
+    QualityGovernor::Report quality;
+
+    bool deterministic = false;
+    long long step = 0;  // steps since the scene was loaded
+    uint64_t hash = 0;   // World::stateHash() after that step, in deterministic mode
+};
+
+// Runs the simulation on a thread of its own, so a slow step never holds
+// up a rendered frame and a slow frame never holds up the simulation.
+//
+// The thread advances in fixed steps of timeStep, paid out of real time as
+// it passes (at most maxStepsPerTick at once, so after a stall the
+// simulation slows down rather than falling behind for good). Between
+// steps it runs the commands other threads posted; only commands and the
+// step itself may touch simulation state. After each batch of steps it
+// fills a RenderSnapshot and publishes it through a triple buffer, which
+// the render thread reads without locking.
+class SimThread {
+public:
+    typedef std::function<void()> Command;
+
+    // step advances the simulation by timeStep; snapshot fills a
+    // RenderSnapshot from the current state. Both run on the simulation
+    // thread.
+    SimThread(Real timeStep, std::function<void()> step, std::function<void(RenderSnapshot&)> snapshot);
+    ~SimThread();
+
+    void start();
+    void stop();  // waits for the step in progress
+
+    // Queues command to run on the simulation thread before its next step
+    void post(Command command);
+
+    // The latest published state. It stays valid, and unchanged, until the
+    // next call; only one thread may read snapshots.
+    const RenderSnapshot& latest();
+
+    // Seconds on the clock RenderSnapshot::time is given in
+    static double now();
+
+    const Real timeStep;
+    int maxStepsPerTick = 4;
+
+private:
+    void run();
+
+    std::function<void()> step;
+    std::function<void(RenderSnapshot&)> snapshot;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+
+    std::mutex commandMutex;
+    std::condition_variable commandPosted;
+    std::vector<Command> pending;
+
+    TripleBuffer<RenderSnapshot> snapshots;
+};
+
+#endif
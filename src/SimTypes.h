@@ -0,0 +1,40 @@
+#pragma once
+#ifndef SIMTYPES_H
+#define SIMTYPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <Eigen/Dense>
+
+// Scalar type of the simulation core, picked at build time.
+// Configure with `cmake -DSIM_FLOAT=ON ..` for a single-precision build.
+#ifdef SIM_FLOAT
+typedef float Real;
+#else
+typedef double Real;
+#endif
+
+// The simulation is planar, so every state vector is 2D
+template <typename Scalar>
+using Vec2T = Eigen::Matrix<Scalar, 2, 1>;
+typedef Vec2T<Real> Vec2;
+
+// Core containers are templated on scalar type; the rest of the
+// playground uses the build's Real instantiation.
+template <typename Scalar> class ParticleStoreT;
+template <typename Scalar> class SpringSetT;
+typedef ParticleStoreT<Real> ParticleStore;
+typedef SpringSetT<Real> SpringSet;
+
+// Folds size bytes into an FNV-1a hash, for the deterministic mode's state
+// hashes. Start from 14695981039346656037.
+inline uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
 #include <unordered_map>
 #include <vector>
 #include <memory>
@@ -26,41 +28,111 @@ class SpatialHashGrid {
 public:
     SpatialHashGrid(float cellSize) : cellSize(cellSize) {}
 
+    // Empties the cells but keeps them, so refilling a scene that barely
+    // moved allocates nothing. Cells that stayed empty for a whole fill
+    // leave the map, which keeps it from growing as polygons wander, but
+    // are kept aside for the next new cell along with their storage.
     void clear() {
-        grid.clear();
+        for (auto it = grid.begin(); it != grid.end();) {
+            if (it->second.empty()) {
+                spare.push_back(grid.extract(it++));
+            }
+            else {
+                it->second.clear();
+                ++it;
+            }
+        }
+        maxRadius = 0.0;
+        occupied = 0;
     }
 
     void insert(const std::shared_ptr<Polygon>& poly) {
         auto center = poly->getCenter();
-        int cx = static_cast<int>(std::floor(center.x() / cellSize));
-        int cy = static_cast<int>(std::floor(center.y() / cellSize));
+        int cx = clampedCell(center.x(), -maxCell, maxCell, 0);
+        int cy = clampedCell(center.y(), -maxCell, maxCell, 0);
         GridCoord coord{ cx, cy };
-        grid[coord].push_back(poly);
+        auto it = grid.find(coord);
+        if (it == grid.end()) {
+            if (spare.empty()) {
+                it = grid.emplace(coord, std::vector<std::shared_ptr<Polygon>>()).first;
+            }
+            else {
+                Map::node_type node = std::move(spare.back());
+                spare.pop_back();
+                node.key() = coord;
+                it = grid.insert(std::move(node)).position;
+            }
+        }
+        auto& cell = it->second;
+        if (cell.empty()) {
+            if (occupied == 0) occupiedMin = occupiedMax = coord;
+            occupiedMin = GridCoord{ std::min(occupiedMin.x, cx), std::min(occupiedMin.y, cy) };
+            occupiedMax = GridCoord{ std::max(occupiedMax.x, cx), std::max(occupiedMax.y, cy) };
+            ++occupied;
+        }
+        cell.push_back(poly);
+        maxRadius = std::max(maxRadius, poly->getBoundingRadius());
     }
 
-    std::vector<std::shared_ptr<Polygon>> getNearby(const std::shared_ptr<Polygon>& poly) const {
-        std::vector<std::shared_ptr<Polygon>> result;
-        auto center = poly->getCenter();
-        int cx = static_cast<int>(std::floor(center.x() / cellSize));
-        int cy = static_cast<int>(std::floor(center.y() / cellSize));
+    // Calls visit(const std::shared_ptr<Polygon>&) for every polygon whose
+    // bounds may overlap the box [boxMin, boxMax]. Polygons are filed by
+    // center, so the box is grown by the largest bounding radius inserted.
+    // A box swept along a fast polygon's path can span any number of cells,
+    // so it is cut down to the occupied ones, and when it still covers more
+    // cells than are occupied, the occupied cells are walked instead. A box
+    // that is not finite covers everything.
+    template <typename Visit>
+    void forEachNear(const Vec2& boxMin, const Vec2& boxMax, Visit visit) const {
+        if (occupied == 0) return;
+        int x0 = clampedCell(boxMin.x() - maxRadius, occupiedMin.x, occupiedMax.x, occupiedMin.x);
+        int y0 = clampedCell(boxMin.y() - maxRadius, occupiedMin.y, occupiedMax.y, occupiedMin.y);
+        int x1 = clampedCell(boxMax.x() + maxRadius, occupiedMin.x, occupiedMax.x, occupiedMax.x);
+        int y1 = clampedCell(boxMax.y() + maxRadius, occupiedMin.y, occupiedMax.y, occupiedMax.y);
+        if (x0 > x1 || y0 > y1) return;
 
-        for (int dx = -1; dx <= 1; ++dx) {
-            for (int dy = -1; dy <= 1; ++dy) {
-                GridCoord coord{ cx + dx, cy + dy };
-                auto it = grid.find(coord);
+        long long cells = ((long long)x1 - x0 + 1) * ((long long)y1 - y0 + 1);
+        if (cells > occupied) {
+            for (auto& entry : grid) {
+                const GridCoord& c = entry.first;
+                if (c.x < x0 || c.x > x1 || c.y < y0 || c.y > y1) continue;
+                for (auto& other : entry.second) {
+                    visit(other);
+                }
+            }
+            return;
+        }
+
+        for (int cx = x0; cx <= x1; ++cx) {
+            for (int cy = y0; cy <= y1; ++cy) {
+                auto it = grid.find(GridCoord{ cx, cy });
                 if (it != grid.end()) {
                     for (auto& other : it->second) {
-                        if (other.get() != poly.get()) {
-                            result.push_back(other);
-                        }
+                        visit(other);
                     }
                 }
             }
         }
-        return result;
     }
 
 private:
+    // Cell along one axis holding coordinate v, limited to [lo, hi] before
+    // it is cast, so huge coordinates cannot overflow; NaN gives ifNaN
+    int clampedCell(Real v, int lo, int hi, int ifNaN) const {
+        double c = std::floor(v / cellSize);
+        if (c != c) return ifNaN;
+        return static_cast<int>(std::clamp(c, (double)lo, (double)hi));
+    }
+
+    // Cells further out than this are filed at the limit, where the
+    // query's cell arithmetic still fits in an int
+    static constexpr int maxCell = 1 << 28;
+
     float cellSize;
-    std::unordered_map<GridCoord, std::vector<std::shared_ptr<Polygon>>> grid;
+    Real maxRadius = 0.0;  // largest bounding radius inserted since the last clear()
+    int occupied = 0;      // cells filled since the last clear()
+    GridCoord occupiedMin{ 0, 0 };  // bounds of those cells
+    GridCoord occupiedMax{ 0, 0 };
+    typedef std::unordered_map<GridCoord, std::vector<std::shared_ptr<Polygon>>> Map;
+    Map grid;
+    std::vector<Map::node_type> spare;  // emptied cells, for reuse
 };
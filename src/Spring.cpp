@@ -1,23 +1,62 @@
 #include "Spring.h"
-#include "Particle.h"
+#include "ParticleStore.h"
+
+#include <cassert>
 
 using namespace std;
-using namespace Eigen;
 
-Spring::Spring(shared_ptr<Particle> p0, shared_ptr<Particle> p1, double alpha)
+template <typename Scalar>
+void SpringSetT<Scalar>::add(int a, int b, Scalar L, Scalar alpha)
 {
-	assert(p0);
-	assert(p1);
-	assert(p0 != p1);
-	this->p0 = p0;
-	this->p1 = p1;
-	this->alpha = 0.0;
-	
-	// Compute L
-	L = (p1->x - p0->x).norm();
+	assert(a != b);
+	i0.push_back(a);
+	i1.push_back(b);
+	restLength.push_back(L);
+	compliance.push_back(alpha);
+	lambda.push_back(Scalar(0));
 }
 
-Spring::~Spring()
+template <typename Scalar>
+void SpringSetT<Scalar>::solve(ParticleStoreT<Scalar>& store, int base, int iterations, Scalar timeStep)
 {
-	
+	typedef Vec2T<Scalar> Vec;
+
+	const int n = size();
+	const int* a = i0.data();
+	const int* b = i1.data();
+	const Scalar* L = restLength.data();
+	const Scalar* alpha = compliance.data();
+	Scalar* lam = lambda.data();
+	Vec* x = store.x.data() + base;
+	const Scalar* w = store.w.data() + base;
+
+	const Scalar invDt2 = Scalar(1) / (timeStep * timeStep);
+	for (int s = 0; s < n; ++s) lam[s] = Scalar(0);
+
+	for (int k = 0; k < iterations; ++k) {
+		for (int s = 0; s < n; ++s) {
+			Scalar w0 = w[a[s]];
+			Scalar w1 = w[b[s]];
+			Scalar alphaTilde = alpha[s] * invDt2;
+			Scalar denom = w0 + w1 + alphaTilde;
+			if (denom == Scalar(0)) continue;
+
+			Vec delta = x[b[s]] - x[a[s]];
+			Scalar dist = delta.norm();
+
+			// Prevent divide by zero
+			if (dist < Scalar(1e-6)) continue;
+
+			// C = dist - L; dLambda = (-C - alphaTilde * lambda) / (w0 + w1 + alphaTilde)
+			Scalar dLambda = (L[s] - dist - alphaTilde * lam[s]) / denom;
+			lam[s] += dLambda;
+
+			Vec correction = (dLambda / dist) * delta;
+			x[a[s]] -= w0 * correction;
+			x[b[s]] += w1 * correction;
+		}
+	}
 }
+
+template class SpringSetT<float>;
+template class SpringSetT<double>;
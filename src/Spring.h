@@ -2,20 +2,30 @@
 #ifndef Spring_H
 #define Spring_H
 
-#include <memory>
+#include <vector>
 
-class Particle;
+#include "SimTypes.h"
 
-class Spring
+// Distance constraints of one polygon, packed as parallel arrays.
+// i0 and i1 are indices into the polygon's particle range.
+template <typename Scalar>
+class SpringSetT
 {
 public:
-	Spring(std::shared_ptr<Particle> p0, std::shared_ptr<Particle> p1, double alpha);
-	virtual ~Spring();
+	void add(int i0, int i1, Scalar restLength, Scalar compliance);
+	int size() const { return static_cast<int>(i0.size()); }
+
+	// XPBD projection over all springs for one (sub)step of length
+	// timeStep; base is the first particle of the owning polygon's range in
+	// the store. Compliance is inverse stiffness (0 = rigid), so how stiff a
+	// spring is follows from it and the step length, not the iteration count.
+	void solve(ParticleStoreT<Scalar>& store, int base, int iterations, Scalar timeStep);
 	
-	std::shared_ptr<Particle> p0;
-	std::shared_ptr<Particle> p1;
-	double L;
-	double alpha;
+	std::vector<int> i0;
+	std::vector<int> i1;
+	std::vector<Scalar> restLength;
+	std::vector<Scalar> compliance;
+	std::vector<Scalar> lambda;  // accumulated multiplier, reset every solve
 };
 
 #endif
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without locks.
+// The writer fills writeSlot() and publishes it; the reader fetches the
+// most recent published slot and reads it for as long as it likes. Each
+// side owns one slot and the third is swapped between them through an
+// atomic, so neither ever waits for the other and the reader never sees a
+// half-written value. Unread values are simply overwritten.
+template <typename T>
+class TripleBuffer {
+public:
+    T& writeSlot() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    // Takes the latest published slot, if there is one the reader has not
+    // seen yet. Returns whether readSlot() changed.
+    bool fetch() {
+        if (!(middle.load(std::memory_order_relaxed) & fresh)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[front]; }
+
+private:
+    static const int index = 3;  // low bits: which slot
+    static const int fresh = 4;  // set while the middle slot is unread
+
+    T slots[3];
+    int back = 0;                  // writer's
+    std::atomic<int> middle{ 1 };  // in transit
+    int front = 2;                 // reader's
+};
+
+#endif
@@ -0,0 +1,472 @@
+#include "World.h"
+#include "Polygon.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+World::World()
+    : awakeGrid(1.0f),  // Adjust cell size as needed
+    sleepingGrid(1.0f)
+{
+}
+
+// Bounds that touch or nearly touch, used to decide what a polygon can reach
+static bool boundsOverlap(const Polygon& a, const Polygon& b, Real margin) {
+    const PolygonGeometry& ga = a.getGeometry();
+    const PolygonGeometry& gb = b.getGeometry();
+    return ga.aabbMin.x() - margin <= gb.aabbMax.x() && gb.aabbMin.x() - margin <= ga.aabbMax.x() &&
+        ga.aabbMin.y() - margin <= gb.aabbMax.y() && gb.aabbMin.y() - margin <= ga.aabbMax.y();
+}
+
+static int findRoot(ScratchVector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Runs one phase over all awake polygons; phases only write the polygon
+// they are given, so the loop order never shows in the result
+template <typename Phase>
+static void forEachPolygon(const vector<shared_ptr<Polygon>>& polys, Phase phase) {
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for (int i = 0; i < static_cast<int>(polys.size()); ++i) {
+        phase(*polys[i], i);
+    }
+}
+
+void World::step(
+    const vector<shared_ptr<Polygon>>& polygons,
+    Real timeStep,
+    int substeps,
+    int collisionIters,
+    Real groundY,
+    const Vec2& gravity,
+    Real damping)
+{
+    // Scratch from the last frame is dead; the arenas rewind on first use
+    FrameArena::nextFrame();
+
+    awake.clear();
+    for (auto& poly : polygons) {
+        if (!poly->isSleeping())
+            awake.push_back(poly);
+    }
+
+    // Tools and removals change the set of sleepers behind our back
+    int sleepers = static_cast<int>(polygons.size() - awake.size());
+    if (sleepingGridDirty || sleepers != sleepingCount) {
+        sleepingGrid.clear();
+        for (auto& poly : polygons) {
+            if (poly->isSleeping())
+                sleepingGrid.insert(poly);
+        }
+        sleepingCount = sleepers;
+        sleepingGridDirty = false;
+    }
+
+    // 1. Broadphase. It runs on the bounds at the start of the step, grown
+    // by how far each polygon can travel, so sleepers in the way are woken
+    // before anything moves.
+    for (auto& poly : awake) {
+        poly->updateGeometry();
+    }
+
+    // Sleepers an awake polygon can reach join this step; the list grows
+    // while we walk it, so whole islands wake one contact at a time
+    for (size_t i = 0; i < awake.size() && sleepingCount > 0; ++i) {
+        wakeTouching(*awake[i], contactMargin + awake[i]->getGeometry().maxSpeed * timeStep);
+    }
+
+    // Work in id order from here on, so the caller's list order (and which
+    // sleepers woke first) cannot change the outcome
+    std::sort(awake.begin(), awake.end(),
+        [](const shared_ptr<Polygon>& a, const shared_ptr<Polygon>& b) { return a->getId() < b->getId(); });
+    awakeGrid.clear();
+    for (auto& poly : awake) awakeGrid.insert(poly);
+
+    findPairs(timeStep);
+    buildIslands();
+    colorPairs();
+
+    // The solver phases run once per substep, with a single spring
+    // iteration each; short substeps are what keep springs and contacts
+    // stiff.
+    const int steps = std::max(substeps, 1);
+    const Real h = timeStep / steps;
+    const Real substepDamping = std::pow(damping, (Real)1.0 / steps);
+
+    for (int sub = 0; sub < steps; ++sub) {
+        // Every substep is a contact frame of its own. Pairs are registered
+        // up front so the parallel solve only reads the contact table.
+        contacts.beginFrame();
+        for (auto& pair : pairs) {
+            contacts.touch(*awake[pair.first], *awake[pair.second]);
+        }
+
+        // Edge normals, bounds and speeds as this substep starts; the
+        // first substep has them from the broadphase
+        if (sub > 0)
+            forEachPolygon(awake, [&](Polygon& poly, int) { poly.updateGeometry(); });
+
+        // 2. Integrate
+        forEachPolygon(awake, [&](Polygon& poly, int) {
+            poly.applyForces(h, gravity, substepDamping);
+            poly.integratePosition(h);
+        });
+
+        // 3. Narrowphase and contacts. Pairs of one color share no polygon
+        // and are solved concurrently; the colors themselves run in order,
+        // so the sweep stays Gauss-Seidel-like even inside one big island
+        for (int k = 0; k < collisionIters; ++k) {
+            for (size_t c = 0; c + 1 < colorStart.size(); ++c) {
+                #ifdef _OPENMP
+                #pragma omp parallel for
+                #endif
+                for (int q = colorStart[c]; q < colorStart[c + 1]; ++q) {
+                    const auto& pair = pairs[colorOrder[q]];
+                    awake[pair.first]->resolveCollisionsWith(awake[pair.second], h, contacts, gjkMinVertices);
+                }
+            }
+        }
+
+        // 4. Springs, or shape matching
+        forEachPolygon(awake, [&](Polygon& poly, int) { poly.solveShape(1, h); });
+
+        // 5. Ground
+        forEachPolygon(awake, [&](Polygon& poly, int) { poly.clampToGround(groundY); });
+
+        // 6. Velocities
+        forEachPolygon(awake, [&](Polygon& poly, int) { poly.updateVelocities(h); });
+    }
+    publishContacts();
+    contacts.endFrame();
+
+    // 7. Friction, once per frame. Ground friction presses with the load
+    // carried down the contact graph; stacking friction reads the
+    // neighbours' velocities as they were before any of it was applied.
+    propagateLoads(gravity);
+    forEachPolygon(awake, [&](Polygon& poly, int i) {
+        poly.snapSmallVelocities();
+        poly.applyGroundFriction(groundY, loads[i], timeStep);
+        poly.recordMeanVelocity();
+    });
+    forEachPolygon(awake, [&](Polygon& poly, int i) {
+        for (int k = contactStart[i]; k < contactStart[i + 1]; ++k) {
+            const PairContact& c = stepContacts[contactOrder[k]];
+            if (c.touching)
+                poly.applyStackingFriction(*awake[c.first == i ? c.second : c.first]);
+        }
+        poly.settle();
+    });
+
+    sleepQuietIslands(timeStep);
+
+    if (sleepingGridDirty) {
+        sleepingGrid.clear();
+        sleepingCount = 0;
+        for (auto& poly : polygons) {
+            if (poly->isSleeping()) {
+                sleepingGrid.insert(poly);
+                ++sleepingCount;
+            }
+        }
+        sleepingGridDirty = false;
+    }
+    awakeCount = static_cast<int>(polygons.size()) - sleepingCount;
+}
+
+void World::wakeTouching(const Polygon& poly, Real reach) {
+    const PolygonGeometry& g = poly.getGeometry();
+    Vec2 grow(reach, reach);
+    sleepingGrid.forEachNear(g.aabbMin - grow, g.aabbMax + grow, [&](const shared_ptr<Polygon>& other) {
+        if (other.get() != &poly && other->isSleeping() && boundsOverlap(poly, *other, reach)) {
+            other->wake();
+            awake.push_back(other);
+            sleepingGridDirty = true;
+        }
+    });
+}
+
+void World::removed(const shared_ptr<Polygon>& poly) {
+    wakeTouching(*poly, contactMargin);
+    sleepingGridDirty = true;
+}
+
+void World::findPairs(Real timeStep) {
+    // awake is in id order, so a neighbour's index is found by its id
+    auto indexOf = [&](const Polygon& poly) {
+        auto it = std::lower_bound(awake.begin(), awake.end(), poly.getId(),
+            [](const shared_ptr<Polygon>& p, int id) { return p->getId() < id; });
+        return static_cast<int>(it - awake.begin());
+    };
+
+    // Two polygons can close at most twice the faster one's travel this
+    // step, so each queries with twice its own sweep and keeps the pairs in
+    // which it is the faster member (ties go to the lower id). A flicked
+    // polygon finds everything along its path from its own query; the rest
+    // keep queries as small as their own speed.
+    pairs.clear();
+    for (size_t i = 0; i < awake.size(); ++i) {
+        const Polygon& poly = *awake[i];
+        const PolygonGeometry& g = poly.getGeometry();
+        Real sweep = contactMargin + 2.0 * g.maxSpeed * timeStep;
+        Vec2 grow(sweep, sweep);
+
+        // Grid cells are coarse; keep only neighbours this step can reach
+        awakeGrid.forEachNear(g.aabbMin - grow, g.aabbMax + grow, [&](const shared_ptr<Polygon>& other) {
+            if (other.get() == &poly) return;
+            Real otherSpeed = other->getGeometry().maxSpeed;
+            if (otherSpeed > g.maxSpeed || (otherSpeed == g.maxSpeed && other->getId() < poly.getId())) return;
+            Real reach = contactMargin + (g.maxSpeed + otherSpeed) * timeStep;
+            if (!boundsOverlap(poly, *other, reach)) return;
+
+            int j = indexOf(*other);
+            pairs.emplace_back(std::min(static_cast<int>(i), j), std::max(static_cast<int>(i), j));
+        });
+    }
+
+    // Pairs in index order, whichever member found them
+    std::sort(pairs.begin(), pairs.end());
+}
+
+void World::buildIslands() {
+    const int n = static_cast<int>(awake.size());
+
+    ScratchVector<int> parent(n);
+    for (int i = 0; i < n; ++i) parent[i] = i;
+
+    for (auto& pair : pairs) {
+        parent[findRoot(parent, pair.first)] = findRoot(parent, pair.second);
+    }
+
+    // Number the islands in order of their lowest member, then list the
+    // members island by island
+    ScratchVector<int> islandOf(n, -1);
+    int numIslands = 0;
+    for (int i = 0; i < n; ++i) {
+        int root = findRoot(parent, i);
+        if (islandOf[root] < 0) islandOf[root] = numIslands++;
+        islandOf[i] = islandOf[root];
+    }
+
+    islandStart.assign(numIslands + 1, 0);
+    for (int i = 0; i < n; ++i) ++islandStart[islandOf[i] + 1];
+    for (int k = 0; k < numIslands; ++k) islandStart[k + 1] += islandStart[k];
+    islandMembers.resize(n);
+    ScratchVector<int> next(islandStart.begin(), islandStart.end() - 1);
+    for (int i = 0; i < n; ++i) islandMembers[next[islandOf[i]]++] = i;
+}
+
+void World::colorPairs() {
+    // Greedy edge coloring: each pair takes the lowest color neither of its
+    // polygons has used yet. Contact graphs of 2D piles have low degree, so
+    // this stays at a handful of colors. A pair always finds a free color
+    // below the two degrees summed, which bounds the table of used colors.
+    const int n = static_cast<int>(awake.size());
+
+    ScratchVector<int> degree(n, 0);
+    for (auto& pair : pairs) {
+        ++degree[pair.first];
+        ++degree[pair.second];
+    }
+    int maxColors = 1;
+    for (int d : degree) maxColors = std::max(maxColors, 2 * d);
+
+    ScratchVector<char> used(static_cast<size_t>(n) * maxColors, 0);
+    colorOf.resize(pairs.size());
+    int numColors = 0;
+    for (int q = 0; q < static_cast<int>(pairs.size()); ++q) {
+        char* a = &used[static_cast<size_t>(pairs[q].first) * maxColors];
+        char* b = &used[static_cast<size_t>(pairs[q].second) * maxColors];
+
+        int c = 0;
+        while (a[c] || b[c]) ++c;
+
+        colorOf[q] = c;
+        a[c] = b[c] = 1;
+        numColors = std::max(numColors, c + 1);
+    }
+
+    // Batch the pairs by color, in pair order within each batch
+    colorStart.assign(numColors + 1, 0);
+    for (int c : colorOf) ++colorStart[c + 1];
+    for (int c = 0; c < numColors; ++c) colorStart[c + 1] += colorStart[c];
+    colorOrder.resize(pairs.size());
+    ScratchVector<int> next(colorStart.begin(), colorStart.end() - 1);
+    for (int q = 0; q < static_cast<int>(pairs.size()); ++q) colorOrder[next[colorOf[q]]++] = q;
+}
+
+void World::publishContacts() {
+    const int n = static_cast<int>(awake.size());
+
+    stepContacts.clear();
+    contactStart.assign(n + 1, 0);
+    for (auto& pair : pairs) {
+        PairContact pc;
+        pc.first = pair.first;
+        pc.second = pair.second;
+
+        // Pairs whose manifold came up empty in the last substep are listed
+        // as not touching
+        const CachedContact* c = contacts.find(*awake[pair.first], *awake[pair.second]);
+        if (c && c->built && c->frame == contacts.currentFrame() && c->manifold.count > 0) {
+            const ContactManifold& m = c->manifold;
+            pc.normal = awake[pair.first]->getId() == c->referenceId ? m.normal : Vec2(-m.normal);
+            for (int k = 0; k < m.count; ++k) {
+                // Speculative points can still be apart; they touch only
+                // once they reach the face or had to push
+                pc.touching = pc.touching || m.separation[k] <= 0.0 || c->normalImpulse[k] > 0.0;
+                pc.depth = std::max(pc.depth, -m.separation[k]);
+                pc.normalImpulse += c->normalImpulse[k];
+            }
+        }
+
+        stepContacts.push_back(pc);
+        ++contactStart[pair.first + 1];
+        ++contactStart[pair.second + 1];
+    }
+
+    // Index the list by polygon, so per-polygon phases find their contacts
+    for (int i = 0; i < n; ++i) contactStart[i + 1] += contactStart[i];
+    contactOrder.resize(contactStart[n]);
+    ScratchVector<int> next(contactStart.begin(), contactStart.end() - 1);
+    for (int q = 0; q < static_cast<int>(stepContacts.size()); ++q) {
+        contactOrder[next[stepContacts[q].first]++] = q;
+        contactOrder[next[stepContacts[q].second]++] = q;
+    }
+}
+
+void World::propagateLoads(const Vec2& gravity) {
+    const int n = static_cast<int>(awake.size());
+
+    // Every contact that pushes one polygon up off another is a support;
+    // its weight is the vertical part of the normal impulse it ended with
+    supports.clear();
+    ScratchVector<int> count(n + 1, 0);
+    ScratchVector<Real> total(n, 0.0);
+    for (const PairContact& c : stepContacts) {
+        if (!c.touching) continue;
+
+        int upper = c.normal.y() > 0.0 ? c.second : c.first;
+        int lower = upper == c.first ? c.second : c.first;
+
+        Real weight = c.normalImpulse * std::abs(c.normal.y());
+        if (weight <= 0.0) continue;
+        supports.push_back({ upper, lower, weight });
+        ++count[upper + 1];
+        total[upper] += weight;
+    }
+
+    // Group the supports by the polygon they hold up
+    for (int i = 0; i < n; ++i) count[i + 1] += count[i];
+    supportOrder.resize(supports.size());
+    {
+        ScratchVector<int> next(count.begin(), count.end() - 1);
+        for (int s = 0; s < static_cast<int>(supports.size()); ++s) {
+            supportOrder[next[supports[s].upper]++] = s;
+        }
+    }
+
+    // Top down, each polygon adds its weight to what rests on it and hands
+    // the sum to its supports in proportion to how hard they push back
+    order.resize(n);
+    for (int i = 0; i < n; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        Real ya = awake[a]->getCenter().y(), yb = awake[b]->getCenter().y();
+        return ya > yb || (ya == yb && a < b);  // level polygons in id order
+    });
+
+    const Real g = gravity.norm();
+    loads.assign(n, 0.0);
+    for (int i : order) {
+        loads[i] += awake[i]->getTotalMass() * g;
+        for (int k = count[i]; k < count[i + 1]; ++k) {
+            const Support& s = supports[supportOrder[k]];
+            loads[s.lower] += loads[i] * s.weight / total[i];
+        }
+    }
+}
+
+void World::sleepQuietIslands(Real timeStep) {
+    // An island sleeps once its least settled member has been quiet long enough
+    for (size_t k = 0; k + 1 < islandStart.size(); ++k) {
+        Real quiet = sleepDelay;
+        for (int m = islandStart[k]; m < islandStart[k + 1]; ++m) {
+            quiet = std::min(quiet, awake[islandMembers[m]]->updateSleepTimer(timeStep, sleepSpeed));
+        }
+        if (quiet < sleepDelay) continue;
+
+        for (int m = islandStart[k]; m < islandStart[k + 1]; ++m) {
+            awake[islandMembers[m]]->sleep();
+        }
+        sleepingGridDirty = true;
+    }
+}
+
+uint64_t World::stateHash(const vector<shared_ptr<Polygon>>& polygons) const {
+    ScratchVector<const Polygon*> byId;
+    byId.reserve(polygons.size());
+    for (auto& poly : polygons) byId.push_back(poly.get());
+    std::sort(byId.begin(), byId.end(),
+        [](const Polygon* a, const Polygon* b) { return a->getId() < b->getId(); });
+
+    // Ids themselves are left out: they count every polygon the program
+    // ever made, so the same scene loaded twice gets different ones
+    uint64_t hash = 14695981039346656037ull;
+    for (const Polygon* poly : byId) hash = poly->hashState(hash);
+
+    // Of the contact cache, only the separating axes reach the next step;
+    // manifolds and impulses are rebuilt every substep. Pairs are hashed by
+    // their polygons' places in id order.
+    auto rankOf = [&](int id) {
+        auto it = std::lower_bound(byId.begin(), byId.end(), id,
+            [](const Polygon* p, int key) { return p->getId() < key; });
+        return it != byId.end() && (*it)->getId() == id ? static_cast<int>(it - byId.begin()) : -1;
+    };
+    struct CachedAxis {
+        int lower, higher;
+        Vec2 axis;
+    };
+    ScratchVector<CachedAxis> axes;
+    contacts.forEachPair([&](int lowerId, int higherId, const CachedContact& c) {
+        int lower = rankOf(lowerId), higher = rankOf(higherId);
+        if (lower >= 0 && higher >= 0) axes.push_back({ lower, higher, c.separatingAxis });
+    });
+    std::sort(axes.begin(), axes.end(), [](const CachedAxis& a, const CachedAxis& b) {
+        return a.lower < b.lower || (a.lower == b.lower && a.higher < b.higher);
+    });
+    for (const CachedAxis& a : axes) {
+        const int ranks[] = { a.lower, a.higher };
+        hash = hashBytes(hash, ranks, sizeof(ranks));
+        hash = hashBytes(hash, a.axis.data(), sizeof(Real) * 2);
+    }
+    return hash;
+}
+
+void World::clear() {
+    contacts.clear();
+    awakeGrid.clear();
+    sleepingGrid.clear();
+    sleepingGridDirty = false;
+    awake.clear();
+    pairs.clear();
+    islandStart.clear();
+    islandMembers.clear();
+    colorOf.clear();
+    colorStart.clear();
+    colorOrder.clear();
+    stepContacts.clear();
+    contactStart.clear();
+    contactOrder.clear();
+    supports.clear();
+    loads.clear();
+    awakeCount = 0;
+    sleepingCount = 0;
+}
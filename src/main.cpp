@@ -1,4 +1,6 @@
+#include <cstdio>
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <memory>
 
@@ -26,10 +28,12 @@
 #include "SceneManager.h"
 #include "PolygonFactory.h"
 #include "Polygon.h"
-#include "Particle.h"
+#include "ParticleStore.h"
 #include "Button.h"
 #include "Tool.h"
-#include "SpatialHashGrid.h"
+#include "World.h"
+#include "QualityGovernor.h"
+#include "SimThread.h"
 
 std::vector<Button> buttons;
 
@@ -37,22 +41,39 @@ using namespace std;
 using namespace Eigen;
 
 // Simulation parameters
-const double timeStep = 1.0 / 60.0;
-int polyCount = 0;
-int springIters = 12;
-int collisionIters = 12;
-const Vector3d gravity(0.0, -9.8, 0.0);
-const double groundY = -1.0;
-const double damping = 0.98;
-const double flickForceScale = 10;
-
-// Globals
+const Real timeStep = 1.0 / 60.0;
+const Vec2 gravity(0.0, -9.8);
+const Real groundY = -1.0;
+const Real damping = 0.98;
+const Real flickForceScale = 10;
+
+// The world runs on its own thread, in fixed steps of timeStep whatever the
+// refresh rate. Input reaches it as commands posted to sim; the window
+// draws the snapshots it publishes, blended between the last two steps.
+void stepWorld();
+void writeSnapshot(RenderSnapshot& snapshot);
+SimThread sim(timeStep, stepWorld, writeSnapshot);
+
+// Owned by the simulation thread, as are the tool states marked below:
+// only stepWorld(), writeSnapshot() and posted commands touch them
 SceneManager sceneManager;
 vector<shared_ptr<Polygon>> polygons;
+World world;
+QualityGovernor governor(1000.0 / 60.0);  // budget for one step in ms; a step must fit in timeStep to keep up
+long long stepCount = 0;  // since the scene was loaded
+
+// Deterministic mode (H) restarts the scene, holds the governor's level and
+// writes the world hash after every step to hashLogPath. Two runs fed the
+// same input, say with OMP_NUM_THREADS=1 and without, must log the same
+// lines; the first line that differs is the first step that diverged.
+bool deterministic = false;
+uint64_t worldHash = 0;
+const char* hashLogPath = "world_hashes.txt";
+std::ofstream hashLog;
+
+// Owned by the main thread
 GLFWwindow* window;
 
-SpatialHashGrid collisionGrid(1.0f);  // Adjust cell size as needed
-
 bool uiHovered = false;
 
 // Camera
@@ -63,10 +84,10 @@ bool panning = false;
 Eigen::Vector2f panStartWorld;
 Eigen::Vector2f panStartMouse;
 
-// Clipboard
+// Clipboard (simulation thread)
 struct ClipboardEntry {
     std::shared_ptr<Polygon> polygon;
-    Eigen::Vector2f offset;  // offset from group center
+    Vec2 offset;  // offset from group center
 };
 std::vector<ClipboardEntry> clipboard;
 
@@ -89,26 +110,28 @@ Tool currentTool = Tool::Flick;
 Tool previousTool = Tool::None;
 bool isQuickSwapping = false;
 
-Eigen::Vector2f normalizedOffset;
+Vec2 normalizedOffset;  // simulation thread, like the flick, grab, eraser and selection state
 
 // Flick globals
 bool flickActive = false;
-Eigen::Vector2f flickStartCenterOffset;
-Eigen::Vector2f flickCurrent;
+Vec2 flickStartCenterOffset;
+Vec2 flickCurrent;
 
 // Grab globals
 bool grabActive = false;
-Eigen::Vector2f grabStartCenterOffset;
-Eigen::Vector2f grabCurrent;
+Vec2 grabStartCenterOffset;
+Vec2 grabCurrent;
 
 // Eraser globals
 std::unordered_map<std::shared_ptr<Polygon>, int> eraserCountdowns;
 const int eraserDelayFrames = 3;
+double eraserCursorX = -1.0, eraserCursorY = -1.0;  // render thread: where the last update was posted from
+bool eraserWasPressed = false;
 
 // Pencil globals
 double lastPencilTime = 0.0;
 const double toolRepeatDelay = 0.2;  // seconds between actions
-Eigen::Vector2f pencilMousePos;
+Vec2 pencilMousePos;
 float pencilSizeX = 0.3f;
 float pencilSizeY = 0.3f;
 int pencilSides = 4;
@@ -117,7 +140,7 @@ float pencilRotation = 0.0f;
 // Selection globals
 std::vector<std::shared_ptr<Polygon>> selectedPolygons;
 bool selecting = false;
-Eigen::Vector2f selectStart, selectEnd;
+Vec2 selectStart, selectEnd;
 
 // Cursors
 GLFWcursor* arrowCursor;
@@ -271,7 +294,7 @@ void updateProjection(GLFWwindow* window) {
     glMatrixMode(GL_MODELVIEW);
 }
 
-Eigen::Vector2f screenToWorld(GLFWwindow* window, double sx, double sy) {
+Vec2 screenToWorld(GLFWwindow* window, double sx, double sy) {
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);  // use framebuffer size, not window size
 
@@ -305,12 +328,14 @@ Eigen::Vector2f screenToWorld(GLFWwindow* window, double sx, double sy) {
         worldY = ((ndcY + 1.0f) / 2.0f) * (top - bottom) + bottom;
     }
 
-    return Eigen::Vector2f(worldX, worldY);
+    return Vec2(worldX, worldY);
 }
 
 
 
-bool isClickOnSelectedPolygon(const Eigen::Vector2f& click) {
+// Tool helpers from here to switchTool() touch polygons, so they only run
+// on the simulation thread, inside posted commands
+bool isClickOnSelectedPolygon(const Vec2& click) {
     for (const auto& poly : selectedPolygons) {
         if (poly->containsPoint(click, 0.05f)) return true;
     }
@@ -324,14 +349,20 @@ void clearSelection() {
     selectedPolygons.clear();
 }
 
-std::shared_ptr<Polygon> getClickedSelectedPolygon(const Eigen::Vector2f& click) {
+// Every deletion goes through here so the world can wake what rested on it
+void removePolygon(const std::shared_ptr<Polygon>& poly) {
+    polygons.erase(std::remove(polygons.begin(), polygons.end(), poly), polygons.end());
+    world.removed(poly);
+}
+
+std::shared_ptr<Polygon> getClickedSelectedPolygon(const Vec2& click) {
     for (const auto& poly : selectedPolygons) {
         if (poly->containsPoint(click, 0.05f)) return poly;
     }
     return nullptr;
 }
 
-void updateEraserHoverOutlines(const Eigen::Vector2f& world) {
+void updateEraserHoverOutlines(const Vec2& world) {
     std::shared_ptr<Polygon> hovered = nullptr;
 
     // Find the hovered polygon
@@ -368,17 +399,20 @@ void switchTool(Tool newTool) {
 
     // Cleanup from Eraser hover effect
     if (currentTool == Tool::Eraser) {
-        for (auto& poly : polygons) {
-            if (std::find(selectedPolygons.begin(), selectedPolygons.end(), poly) != selectedPolygons.end()) {
-                poly->outlineColor = selectedOutlineColor;
-            }
-            else {
-                poly->outlineColor = poly->defaultOutlineColor;
+        sim.post([] {
+            for (auto& poly : polygons) {
+                if (std::find(selectedPolygons.begin(), selectedPolygons.end(), poly) != selectedPolygons.end()) {
+                    poly->outlineColor = selectedOutlineColor;
+                }
+                else {
+                    poly->outlineColor = poly->defaultOutlineColor;
+                }
             }
-        }
+        });
     }
 
     currentTool = newTool;
+    eraserCursorX = eraserCursorY = -1.0;  // hover outlines come back on the next update
 
     if (window) {
         switch (newTool) {
@@ -396,8 +430,8 @@ void switchTool(Tool newTool) {
         // Re-run hover logic in case cursor is already over a polygon
         double sx, sy;
         glfwGetCursorPos(window, &sx, &sy);
-        Eigen::Vector2f worldPos = screenToWorld(window, sx, sy);
-        updateEraserHoverOutlines(worldPos);
+        Vec2 worldPos = screenToWorld(window, sx, sy);
+        sim.post([worldPos] { updateEraserHoverOutlines(worldPos); });
     }
 
 }
@@ -432,42 +466,10 @@ void character_callback(GLFWwindow* window, unsigned int codepoint) {
 }
 
 
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-    double sx, sy;
-    glfwGetCursorPos(window, &sx, &sy);
-    Eigen::Vector2f worldClick = screenToWorld(window, sx, sy);
-
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-        // Convert to float screen-space (no need to map to world space)
-        float mouseX = static_cast<float>(sx);
-        float mouseY = static_cast<float>(sy);
-
-        for (auto& b : buttons) {
-            if (b.isHovered(mouseX, mouseY)) {
-                b.click();
-                uiHovered = true;
-                return; // Stop here if a button was clicked
-            }
-        }
-    }
-
-    // If not button press, try to use current tool
-    switch (currentTool) {
-
-    case Tool::View:
-        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-            panning = true;
-
-            double sx, sy;
-            glfwGetCursorPos(window, &sx, &sy);
-            panStartMouse = Eigen::Vector2f(sx, sy);
-            panStartWorld = cameraPosition;
-        }
-
-        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-            panning = false;
-        }
-        break;
+// What a mouse button does with the tools that act on polygons; runs on
+// the simulation thread
+void useTool(Tool tool, int button, int action, int mods, const Vec2& worldClick) {
+    switch (tool) {
 
     case Tool::Flick:
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
@@ -490,8 +492,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 }
 
                 if (clickedPolygon) {
-                    Eigen::Vector2f rawOffset = worldClick - clickedPolygon->getCenter();
-                    float baseRadius = clickedPolygon->getBoundingRadius();
+                    Vec2 rawOffset = worldClick - clickedPolygon->getCenter();
+                    Real baseRadius = clickedPolygon->getBoundingRadius();
                     normalizedOffset = rawOffset / baseRadius;
                     flickCurrent = worldClick;
                     flickActive = true;
@@ -504,10 +506,10 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             else if (action == GLFW_RELEASE && flickActive) {
                 flickActive = false;
                 for (auto& poly : selectedPolygons) {
-                    float currentRadius = poly->getBoundingRadius();
-                    Eigen::Vector2f adjustedOffset = normalizedOffset * currentRadius;
-                    Eigen::Vector2f start = poly->getCenter() + adjustedOffset;
-                    Eigen::Vector2f dir = start - flickCurrent;
+                    Real currentRadius = poly->getBoundingRadius();
+                    Vec2 adjustedOffset = normalizedOffset * currentRadius;
+                    Vec2 start = poly->getCenter() + adjustedOffset;
+                    Vec2 dir = start - flickCurrent;
 
                     if (dir.norm() > 1e-4) {
                         poly->applyImpulseAt(start, dir * flickForceScale);
@@ -541,8 +543,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 }
 
                 if (clickedPolygon) {
-                    Eigen::Vector2f rawOffset = worldClick - clickedPolygon->getCenter();
-                    float baseRadius = clickedPolygon->getBoundingRadius();
+                    Vec2 rawOffset = worldClick - clickedPolygon->getCenter();
+                    Real baseRadius = clickedPolygon->getBoundingRadius();
                     normalizedOffset = rawOffset / baseRadius;
                     grabCurrent = worldClick;
                     grabActive = true;
@@ -581,13 +583,13 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 if (isSelected) {
                     // If selected, delete all selected polygons
                     for (const auto& poly : selectedPolygons) {
-                        polygons.erase(std::remove(polygons.begin(), polygons.end(), poly), polygons.end());
+                        removePolygon(poly);
                     }
                     selectedPolygons.clear();
                 }
                 else {
                     // If not selected, delete just the clicked one and clear selection
-                    polygons.erase(std::remove(polygons.begin(), polygons.end(), clickedPolygon), polygons.end());
+                    removePolygon(clickedPolygon);
                     clearSelection();
                 }
             }
@@ -598,23 +600,6 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         }
         break;
 
-    case Tool::Pencil:
-        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-            polygons.push_back(
-                PolygonFactory::CreateRegularPolygon(
-                    Vector3d(pencilMousePos.x(), pencilMousePos.y(), 0.0),
-                    pencilSides,
-                    pencilSizeX, pencilSizeY,
-                    pencilRotation
-                )
-            );
-            lastPencilTime = glfwGetTime(); // Prevent immediate double-spawn
-        }
-        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
-            pencilSides = (pencilSides % 8) + 3; // cycle 310 sides
-        }
-        break;
-
     case Tool::Select:
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
             std::shared_ptr<Polygon> clickedPolygon = nullptr;
@@ -667,8 +652,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 
             for (auto& poly : polygons) {
                 bool intersects = false;
-                for (auto& particle : poly->particles) {
-                    Eigen::Vector2f pos(particle->x.x(), particle->x.y());
+                for (int i = 0; i < poly->numParticles(); ++i) {
+                    const Vec2& pos = poly->particlePosition(i);
                     if (pos.x() >= xMin && pos.x() <= xMax &&
                         pos.y() >= yMin && pos.y() <= yMax) {
                         intersects = true;
@@ -683,7 +668,75 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         }
         break;
 
+    default:
+        break;
+    }
+}
+
+// Adds a polygon as the pencil is set up now, under the cursor
+void spawnPencilPolygon() {
+    Vec2 pos = pencilMousePos;
+    int sides = pencilSides;
+    Real sizeX = pencilSizeX, sizeY = pencilSizeY, rotation = pencilRotation;
+    sim.post([=] {
+        polygons.push_back(PolygonFactory::CreateRegularPolygon(pos, sides, sizeX, sizeY, rotation));
+    });
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    double sx, sy;
+    glfwGetCursorPos(window, &sx, &sy);
+    Vec2 worldClick = screenToWorld(window, sx, sy);
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        // Convert to float screen-space (no need to map to world space)
+        float mouseX = static_cast<float>(sx);
+        float mouseY = static_cast<float>(sy);
+
+        for (auto& b : buttons) {
+            if (b.isHovered(mouseX, mouseY)) {
+                b.click();
+                uiHovered = true;
+                return; // Stop here if a button was clicked
+            }
+        }
+    }
+
+    // If not button press, try to use current tool
+    Tool tool = currentTool;
+    switch (tool) {
+
+    case Tool::View:
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+            panning = true;
+
+            double sx, sy;
+            glfwGetCursorPos(window, &sx, &sy);
+            panStartMouse = Eigen::Vector2f(sx, sy);
+            panStartWorld = cameraPosition;
+        }
+
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
+            panning = false;
+        }
+        break;
+
+    case Tool::Pencil:
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+            spawnPencilPolygon();
+            lastPencilTime = glfwGetTime(); // Prevent immediate double-spawn
+        }
+        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+            pencilSides = (pencilSides % 8) + 3; // cycle 310 sides
+        }
+        break;
 
+    case Tool::Flick:
+    case Tool::Grab:
+    case Tool::Eraser:
+    case Tool::Select:
+        sim.post([=] { useTool(tool, button, action, mods, worldClick); });
+        break;
 
     default:
         break;
@@ -712,13 +765,13 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     if (currentTool == Tool::View) {
         double sx, sy;
         glfwGetCursorPos(window, &sx, &sy);
-        Eigen::Vector2f worldBefore = screenToWorld(window, sx, sy);
+        Vec2 worldBefore = screenToWorld(window, sx, sy);
 
         float zoomFactor = (yoffset > 0) ? 1.1f : 1.0f / 1.1f;
         cameraZoom *= zoomFactor;
 
-        Eigen::Vector2f worldAfter = screenToWorld(window, sx, sy);
-        cameraPosition += worldBefore - worldAfter;
+        Vec2 worldAfter = screenToWorld(window, sx, sy);
+        cameraPosition += (worldBefore - worldAfter).cast<float>();
 
         int w, h;
         glfwGetFramebufferSize(window, &w, &h);
@@ -730,50 +783,72 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 
 
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
-    Eigen::Vector2f world = screenToWorld(window, xpos, ypos);
+    Vec2 world = screenToWorld(window, xpos, ypos);
 
     if (currentTool == Tool::View && panning) {
         double sx, sy;
         glfwGetCursorPos(window, &sx, &sy);
-        Eigen::Vector2f newWorld = screenToWorld(window, sx, sy);
-        Eigen::Vector2f startWorld = screenToWorld(window, panStartMouse.x(), panStartMouse.y());
-        cameraPosition = panStartWorld + (startWorld - newWorld);
+        Vec2 newWorld = screenToWorld(window, sx, sy);
+        Vec2 startWorld = screenToWorld(window, panStartMouse.x(), panStartMouse.y());
+        cameraPosition = panStartWorld + (startWorld - newWorld).cast<float>();
 
         int w, h;
         glfwGetFramebufferSize(window, &w, &h);
         updateProjection(window);
     }
 
-    if (flickActive) {
-        flickCurrent = world;
-    }
-    if (grabActive) {
-        grabCurrent = world;
-    }
-    if (currentTool == Tool::Select && selecting) {
-        selectEnd = screenToWorld(window, xpos, ypos);
-    }
-    pencilMousePos = screenToWorld(window, xpos, ypos);
+    Tool tool = currentTool;
+    sim.post([=] {
+        if (flickActive) {
+            flickCurrent = world;
+        }
+        if (grabActive) {
+            grabCurrent = world;
+        }
+        if (tool == Tool::Select && selecting) {
+            selectEnd = world;
+        }
+    });
+    pencilMousePos = world;
 }
 
+// Runs on the simulation thread, or before it starts
 void LoadScene(int key) {
 	sceneManager.LoadScene(key);
 	polygons = sceneManager.GetPolygons();
+    world.clear();
     selectedPolygons.clear();
+    stepCount = 0;
 }
 
 void initScenes() {
 
     sceneManager.RegisterScene(1, []() {
-        return PolygonFactory::CreateWall(Vector3d(-1.2, -.8, 0), 3, 3, 0.4, 0.4);
+        return PolygonFactory::CreateWall(Vec2(-1.2, -.8), 3, 3, 0.4, 0.4);
         });
 
     sceneManager.RegisterScene(2, []() {
-        return PolygonFactory::CreateStackedRectangles(Vector3d(0, -.8, 0), 4, 0.2, 0.4);
+        return PolygonFactory::CreateStackedRectangles(Vec2(0, -.8), 4, 0.2, 0.4);
         });
 
     sceneManager.RegisterScene(3, []() {
-        return PolygonFactory::CreateGridOfPolygons(Vector3d(0, 0.5, 0), 2, 3, 6, 0.5, 0.5, 0.1, 0.1);
+        return PolygonFactory::CreateGridOfPolygons(Vec2(0, 0.5), 2, 3, 6, 0.5, 0.5, 0.1, 0.1);
+        });
+
+    sceneManager.RegisterScene(4, []() {
+        return PolygonFactory::CreateWall(Vec2(-0.9, -.85), 8, 6, 0.3, 0.3, 0.0, BodyMode::Rigid);
+        });
+
+    sceneManager.RegisterScene(5, []() {
+        return PolygonFactory::CreateStackedRectangles(Vec2(0, -.8), 8, 0.2, 0.4, 0.0, BodyMode::ShapeMatched);
+        });
+
+    // Round 16-gons, whose pairs are tested with GJK/EPA (see
+    // World::gjkMinVertices). They are rigid: a spring network past about
+    // 10 sides sags under its own weight, which is also why the pencil
+    // stops at 10.
+    sceneManager.RegisterScene(6, []() {
+        return PolygonFactory::CreateGridOfPolygons(Vec2(-1.0, -0.78), 4, 5, 16, 0.4, 0.4, 0.02, 0.02, BodyMode::Rigid);
         });
 
     // Load the first scene by default
@@ -833,7 +908,7 @@ void initButtons() {
 
 }
 
-bool isPolygonVisible(const std::shared_ptr<Polygon>& poly, GLFWwindow* window) {
+bool isPolygonVisible(const RenderSnapshot::Shape& shape, GLFWwindow* window) {
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
     float aspect = width / static_cast<float>(height);
@@ -857,13 +932,10 @@ bool isPolygonVisible(const std::shared_ptr<Polygon>& poly, GLFWwindow* window)
         top = cameraPosition.y() + viewHeight;
     }
 
-    Eigen::Vector2f center = poly->getCenter();
-    float r = poly->getBoundingRadius();
-
-    return !(center.x() + r < left ||
-        center.x() - r > right ||
-        center.y() + r < bottom ||
-        center.y() - r > top);
+    return !(shape.aabbMax.x() < left ||
+        shape.aabbMin.x() > right ||
+        shape.aabbMax.y() < bottom ||
+        shape.aabbMin.y() > top);
 }
 
 
@@ -931,26 +1003,96 @@ void drawGrid(float spacing = 1.0f) {
 
 
 
-void display(GLFWwindow* window) {
+// The grab tool pulls with a spring toward the cursor, once per world step
+void applyGrabForce() {
+    if (!grabActive) return;
+
+    for (auto& poly : selectedPolygons) {
+        Real currentRadius = poly->getBoundingRadius();
+        Vec2 adjustedOffset = normalizedOffset * currentRadius;
+        Vec2 grabStart = poly->getCenter() + adjustedOffset;
+        Vec2 pull = grabCurrent - grabStart;
+
+        if (pull.norm() > 1e-4f) {
+            Real stiffness = 30.0;
+            Vec2 force = pull * stiffness * timeStep;
+            poly->applyImpulseAt(grabStart, force);
+        }
+    }
+}
 
-    collisionGrid.clear();
+// One fixed step, on the simulation thread
+void stepWorld() {
+    ParticleStore::shared()->markStepStart();
+    applyGrabForce();
+
+    // The governor picks substeps and contact iterations (per substep) to
+    // fit the step budget
+    double start = SimThread::now();
+    world.step(polygons, timeStep, governor.substeps(), governor.collisionIters(), groundY, gravity, damping);
+    double stepMs = (SimThread::now() - start) * 1000.0;
+    governor.record(stepMs);
+
+    ++stepCount;
+    if (deterministic) {
+        worldHash = world.stateHash(polygons);
+        hashLog << stepCount << ' ' << std::hex << worldHash << std::dec << '\n';
+    }
+}
+
+// Copies what display() draws out of the simulation, on its thread
+void writeSnapshot(RenderSnapshot& snapshot) {
+    const ParticleStore& store = *ParticleStore::shared();
+
+    snapshot.from.clear();
+    snapshot.to.clear();
+    snapshot.shapes.clear();
     for (auto& poly : polygons) {
-        collisionGrid.insert(poly);
+        RenderSnapshot::Shape shape;
+        shape.first = static_cast<int>(snapshot.to.size());
+        shape.count = poly->numParticles();
+        shape.fillColor = poly->fillColor;
+        shape.outlineColor = poly->outlineColor;
+        shape.aabbMin = poly->getGeometry().aabbMin;
+        shape.aabbMax = poly->getGeometry().aabbMax;
+        snapshot.shapes.push_back(shape);
+
+        int b = poly->particleBegin();
+        snapshot.from.insert(snapshot.from.end(), store.stepStart.begin() + b, store.stepStart.begin() + b + shape.count);
+        snapshot.to.insert(snapshot.to.end(), store.x.begin() + b, store.x.begin() + b + shape.count);
     }
 
-    polyCount = polygons.size();
-    springIters = polyCount > 100 ? 3 : 6;
-    collisionIters = polyCount > 100 ? 2 : 12;
-
-    #ifdef _OPENMP
-    #pragma omp parallel for schedule(dynamic)
-    #endif
-    for (int i = 0; i < polygons.size(); ++i) {
-        auto& poly = polygons[i];
-        auto neighbors = collisionGrid.getNearby(poly);
-        poly->step(timeStep, springIters, collisionIters, groundY, neighbors, gravity, damping);
+    // Flick and grab lines run from the grabbed point of each polygon
+    snapshot.lines.clear();
+    if (flickActive || grabActive) {
+        snapshot.lineColor = flickActive ? flickLineColor : grabLineColor;
+        for (auto& poly : selectedPolygons) {
+            Real currentRadius = poly->getBoundingRadius();
+            Vec2 adjustedOffset = normalizedOffset * currentRadius;
+            snapshot.lines.push_back(poly->getCenter() + adjustedOffset);
+            snapshot.lines.push_back(flickActive ? flickCurrent : grabCurrent);
+        }
     }
+    snapshot.selecting = selecting;
+    snapshot.selectStart = selectStart;
+    snapshot.selectEnd = selectEnd;
+
+    snapshot.numPolygons = static_cast<int>(polygons.size());
+    snapshot.numSleeping = world.numSleeping();
+    snapshot.quality = governor.report();
 
+    snapshot.deterministic = deterministic;
+    snapshot.step = stepCount;
+    snapshot.hash = worldHash;
+}
+
+void display(GLFWwindow* window) {
+    const RenderSnapshot& snapshot = sim.latest();
+
+    // The snapshot is the end of the latest step; draw as far past its
+    // start as real time has run since, so motion stays smooth when the
+    // screen refreshes faster or slower than the simulation
+    Real alpha = static_cast<Real>(std::clamp((SimThread::now() - snapshot.time) / timeStep, 0.0, 1.0));
 
     updateProjection(window);
     glLoadIdentity(); // Reset modelview
@@ -959,28 +1101,32 @@ void display(GLFWwindow* window) {
 
     drawGrid(1.0f);  // Or 1.0f for wider spacing
 
-
-
-    for (auto& poly : polygons) {
-        if (isPolygonVisible(poly, window)) {
-            poly->draw();
+    static std::vector<Vec2> blended;
+    for (auto& shape : snapshot.shapes) {
+        if (isPolygonVisible(shape, window)) {
+            blended.resize(shape.count);
+            for (int i = 0; i < shape.count; ++i) {
+                const Vec2& from = snapshot.from[shape.first + i];
+                blended[i] = from + alpha * (snapshot.to[shape.first + i] - from);
+            }
+            drawPolygonOffset(blended.data(), shape.count, 0, true, shape.fillColor);
+            drawPolygonOffset(blended.data(), shape.count, 0, false, shape.outlineColor);
         }
     }
 
     if (currentTool == Tool::Pencil) {
-        auto ghost = PolygonFactory::CreateRegularPolygon(
-            Vector3d(pencilMousePos.x(), pencilMousePos.y(), 0.0),
-            pencilSides,
-            pencilSizeX, pencilSizeY,
-            pencilRotation
-        );
-        ghost->fillColor.w() = 0.3f;
-        ghost->outlineColor.w() = 0.6f;
-        
-        ghost->draw();
+        // A preview only; it is drawn from its corners, not built as a polygon
+        Vec2 ghost[10];
+        for (int i = 0; i < pencilSides; ++i) {
+            ghost[i] = Polygon::regularCorner(pencilMousePos, i, pencilSides, pencilSizeX, pencilSizeY, pencilRotation);
+        }
+        drawPolygonOffset(ghost, pencilSides, 0, true, Eigen::Vector4f(0.1f, 0.1f, 0.1f, 0.3f));
+        drawPolygonOffset(ghost, pencilSides, 0, false, Eigen::Vector4f(1.0f, 1.0f, 1.0f, 0.6f));
     }
 
-    if (currentTool == Tool::Select && selecting) {
+    const Vec2& selectStart = snapshot.selectStart;
+    const Vec2& selectEnd = snapshot.selectEnd;
+    if (currentTool == Tool::Select && snapshot.selecting) {
         glColor4f(selectionBoxFill.x(), selectionBoxFill.y(), selectionBoxFill.z(), selectionBoxFill.w());
         glBegin(GL_QUADS);
         glVertex2f(selectStart.x(), selectStart.y());
@@ -999,49 +1145,16 @@ void display(GLFWwindow* window) {
         glEnd();
     }
 
-    if (flickActive) {
+    if (!snapshot.lines.empty()) {
         glLineWidth(3.0f);
-        glColor3f(flickLineColor.x(), flickLineColor.y(), flickLineColor.z());
+        glColor3f(snapshot.lineColor.x(), snapshot.lineColor.y(), snapshot.lineColor.z());
         glBegin(GL_LINES);
-        for (auto& poly : selectedPolygons) {
-            float currentRadius = poly->getBoundingRadius();
-            Eigen::Vector2f adjustedOffset = normalizedOffset * currentRadius;
-            Eigen::Vector2f start = poly->getCenter() + adjustedOffset;
-            glVertex2f(start.x(), start.y());
-            glVertex2f(flickCurrent.x(), flickCurrent.y());
+        for (const Vec2& point : snapshot.lines) {
+            glVertex2f(point.x(), point.y());
         }
         glEnd();
     }
 
-
-    else if (grabActive) {
-        glLineWidth(3.0f);
-        glColor3f(grabLineColor.x(), grabLineColor.y(), grabLineColor.z());
-        glBegin(GL_LINES);
-        for (auto& poly : selectedPolygons) {
-            float currentRadius = poly->getBoundingRadius();
-            Eigen::Vector2f adjustedOffset = normalizedOffset * currentRadius;
-            Eigen::Vector2f start = poly->getCenter() + adjustedOffset;
-            glVertex2f(start.x(), start.y());
-            glVertex2f(grabCurrent.x(), grabCurrent.y());
-        }
-        glEnd();
-
-        // Apply force
-        for (auto& poly : selectedPolygons) {
-            float currentRadius = poly->getBoundingRadius();
-            Eigen::Vector2f adjustedOffset = normalizedOffset * currentRadius;
-            Eigen::Vector2f grabStart = poly->getCenter() + adjustedOffset;
-            Eigen::Vector2f pull = grabCurrent - grabStart;
-
-            if (pull.norm() > 1e-4f) {
-                float stiffness = 30.0f;
-                Eigen::Vector2f force = pull * stiffness * timeStep;
-                poly->applyImpulseAt(grabStart, force);
-            }
-        }
-    }
-
     // UI rendering
     setScreenSpaceProjection(window);
     glLoadIdentity();  // Reset modelview again
@@ -1053,22 +1166,24 @@ void display(GLFWwindow* window) {
 }
 
 void resetScene(GLFWwindow* window) {
-    polygons.clear();
-    selectedPolygons.clear();
+    sim.post([] {
+        polygons.clear();
+        world.clear();
+        selectedPolygons.clear();
+        LoadScene(1);
+    });
     cameraPosition = Eigen::Vector2f(0.0f, 0.0f);
     cameraZoom = 1.0f;
 
     int w, h;
     glfwGetFramebufferSize(window, &w, &h);
     updateProjection(window);
-
-    LoadScene(1);
 }
 
-Eigen::Vector2f computeGroupCenter(const std::vector<std::shared_ptr<Polygon>>& polys) {
-    if (polys.empty()) return Eigen::Vector2f(0, 0);
+Vec2 computeGroupCenter(const std::vector<std::shared_ptr<Polygon>>& polys) {
+    if (polys.empty()) return Vec2(0, 0);
 
-    Eigen::Vector2f sum(0, 0);
+    Vec2 sum(0, 0);
     for (const auto& poly : polys) {
         sum += poly->getCenter();
     }
@@ -1085,122 +1200,147 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
             resetScene(window);
         }
 
-        // DELETE: Remove selected polygons
-        if (key == GLFW_KEY_DELETE) {
-            for (const auto& poly : selectedPolygons) {
-                polygons.erase(std::remove(polygons.begin(), polygons.end(), poly), polygons.end());
-            }
-            selectedPolygons.clear();
+        // F1 to F6 load the scenes registered in initScenes()
+        if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F6) {
+            int scene = key - GLFW_KEY_F1 + 1;
+            sim.post([scene] {
+                polygons.clear();
+                world.clear();
+                LoadScene(scene);
+            });
         }
 
-        if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_A) {
-            for (auto& poly : selectedPolygons) {
-                poly->outlineColor = poly->defaultOutlineColor;
+        if (key == GLFW_KEY_H) {
+            sim.post([] {
+                deterministic = !deterministic;
+                governor.hold(deterministic);
+                if (deterministic) {
+                    // Start from the same state every time
+                    hashLog.open(hashLogPath, std::ios::trunc);
+                    polygons.clear();
+                    world.clear();
+                    LoadScene(1);
+                }
+                else {
+                    hashLog.close();
+                }
+            });
+        }
+
+        // Edits to the scene run on the simulation thread; paste and
+        // duplicate place the polygons where the cursor is now
+        double sx, sy;
+        glfwGetCursorPos(window, &sx, &sy);
+        Vec2 cursorWorld = screenToWorld(window, sx, sy);
+        sim.post([=] {
+            // DELETE: Remove selected polygons
+            if (key == GLFW_KEY_DELETE) {
+                for (const auto& poly : selectedPolygons) {
+                    removePolygon(poly);
+                }
+                selectedPolygons.clear();
             }
-            selectedPolygons.clear();
 
-            for (const auto& poly : polygons) {
-                selectedPolygons.push_back(poly);
-                poly->outlineColor = selectedOutlineColor;
+            if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_A) {
+                for (auto& poly : selectedPolygons) {
+                    poly->outlineColor = poly->defaultOutlineColor;
+                }
+                selectedPolygons.clear();
+
+                for (const auto& poly : polygons) {
+                    selectedPolygons.push_back(poly);
+                    poly->outlineColor = selectedOutlineColor;
+                }
             }
-        }
 
 
-        // COPY: Ctrl+C
-        if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_C) {
-            clipboard.clear();
-            if (selectedPolygons.empty()) return;
+            // COPY: Ctrl+C
+            if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_C) {
+                clipboard.clear();
+                if (selectedPolygons.empty()) return;
 
-            Eigen::Vector2f groupCenter = computeGroupCenter(selectedPolygons);
+                Vec2 groupCenter = computeGroupCenter(selectedPolygons);
 
-            for (const auto& poly : selectedPolygons) {
-                auto copy = std::make_shared<Polygon>(*poly);
-                Eigen::Vector2f offset = poly->getCenter() - groupCenter;
-                clipboard.push_back({ copy, offset });
+                for (const auto& poly : selectedPolygons) {
+                    auto copy = std::make_shared<Polygon>(*poly);
+                    Vec2 offset = poly->getCenter() - groupCenter;
+                    clipboard.push_back({ copy, offset });
+                }
             }
-        }
 
-        // CUT: Ctrl+X
-        if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_X) {
-            clipboard.clear();
-            if (selectedPolygons.empty()) return;
+            // CUT: Ctrl+X
+            if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_X) {
+                clipboard.clear();
+                if (selectedPolygons.empty()) return;
 
-            Eigen::Vector2f groupCenter = computeGroupCenter(selectedPolygons);
+                Vec2 groupCenter = computeGroupCenter(selectedPolygons);
 
-            for (const auto& poly : selectedPolygons) {
-                auto copy = std::make_shared<Polygon>(*poly);
-                Eigen::Vector2f offset = poly->getCenter() - groupCenter;
-                clipboard.push_back({ copy, offset });
-            }
+                for (const auto& poly : selectedPolygons) {
+                    auto copy = std::make_shared<Polygon>(*poly);
+                    Vec2 offset = poly->getCenter() - groupCenter;
+                    clipboard.push_back({ copy, offset });
+                }
 
-            // Delete selected polygons
-            for (const auto& poly : selectedPolygons) {
-                polygons.erase(std::remove(polygons.begin(), polygons.end(), poly), polygons.end());
+                // Delete selected polygons
+                for (const auto& poly : selectedPolygons) {
+                    removePolygon(poly);
+                }
+                selectedPolygons.clear();
             }
-            selectedPolygons.clear();
-        }
 
+            // PASTE: Ctrl+V
+            if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_V) {
+                if (clipboard.empty()) return;
 
-        // PASTE: Ctrl+V
-        if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_V) {
-            if (clipboard.empty()) return;
-
-            double sx, sy;
-            glfwGetCursorPos(window, &sx, &sy);
-            Eigen::Vector2f cursorWorld = screenToWorld(window, sx, sy);
-
-            std::vector<std::shared_ptr<Polygon>> newPolygons;
+                std::vector<std::shared_ptr<Polygon>> newPolygons;
 
-            for (const auto& entry : clipboard) {
-                auto clone = std::make_shared<Polygon>(*entry.polygon);
-                Eigen::Vector2f newCenter = cursorWorld + entry.offset;
-                clone->moveCenterTo(Vector3d(newCenter.x(), newCenter.y(), 0));
-                polygons.push_back(clone);
-                newPolygons.push_back(clone);
-            }
+                for (const auto& entry : clipboard) {
+                    auto clone = std::make_shared<Polygon>(*entry.polygon);
+                    Vec2 newCenter = cursorWorld + entry.offset;
+                    clone->moveCenterTo(newCenter);
+                    polygons.push_back(clone);
+                    newPolygons.push_back(clone);
+                }
 
-            // Reselect pasted polygons
-            for (auto& poly : selectedPolygons) {
-                poly->outlineColor = poly->defaultOutlineColor;
-            }
-            selectedPolygons = newPolygons;
-            for (auto& poly : selectedPolygons) {
-                poly->outlineColor = selectedOutlineColor;
+                // Reselect pasted polygons
+                for (auto& poly : selectedPolygons) {
+                    poly->outlineColor = poly->defaultOutlineColor;
+                }
+                selectedPolygons = newPolygons;
+                for (auto& poly : selectedPolygons) {
+                    poly->outlineColor = selectedOutlineColor;
+                }
             }
-        }
 
 
 
-        // DUPLICATE: Ctrl+D
-        if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_D) {
-            if (selectedPolygons.empty()) return;
+            // DUPLICATE: Ctrl+D
+            if ((mods & GLFW_MOD_CONTROL) && key == GLFW_KEY_D) {
+                if (selectedPolygons.empty()) return;
 
-            double sx, sy;
-            glfwGetCursorPos(window, &sx, &sy);
-            Eigen::Vector2f cursorWorld = screenToWorld(window, sx, sy);
+                Vec2 groupCenter = computeGroupCenter(selectedPolygons);
 
-            Eigen::Vector2f groupCenter = computeGroupCenter(selectedPolygons);
+                std::vector<std::shared_ptr<Polygon>> newPolygons;
 
-            std::vector<std::shared_ptr<Polygon>> newPolygons;
-
-            for (const auto& poly : selectedPolygons) {
-                auto clone = std::make_shared<Polygon>(*poly);
-                Eigen::Vector2f offset = poly->getCenter() - groupCenter;
-                Eigen::Vector2f newCenter = cursorWorld + offset;
-                clone->moveCenterTo(Vector3d(newCenter.x(), newCenter.y(), 0));
-                polygons.push_back(clone);
-                newPolygons.push_back(clone);
-            }
+                for (const auto& poly : selectedPolygons) {
+                    auto clone = std::make_shared<Polygon>(*poly);
+                    Vec2 offset = poly->getCenter() - groupCenter;
+                    Vec2 newCenter = cursorWorld + offset;
+                    clone->moveCenterTo(newCenter);
+                    polygons.push_back(clone);
+                    newPolygons.push_back(clone);
+                }
 
-            // Reselect clones
-            for (auto& poly : selectedPolygons) {
-                poly->outlineColor = poly->defaultOutlineColor;
-            }
-            selectedPolygons = newPolygons;
-            for (auto& poly : selectedPolygons) {
-                poly->outlineColor = selectedOutlineColor;
+                // Reselect clones
+                for (auto& poly : selectedPolygons) {
+                    poly->outlineColor = poly->defaultOutlineColor;
+                }
+                selectedPolygons = newPolygons;
+                for (auto& poly : selectedPolygons) {
+                    poly->outlineColor = selectedOutlineColor;
+                }
             }
-        }
+        });
 
         // Tools
         switch (key) {
@@ -1246,14 +1386,7 @@ void handlePencilToolRepeat(GLFWwindow* window) {
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
         double now = glfwGetTime();
         if (now - lastPencilTime >= toolRepeatDelay) {
-            polygons.push_back(
-                PolygonFactory::CreateRegularPolygon(
-                    Vector3d(pencilMousePos.x(), pencilMousePos.y(), 0.0),
-                    pencilSides,
-                    pencilSizeX, pencilSizeY,
-                    pencilRotation
-                )
-            );
+            spawnPencilPolygon();
             lastPencilTime = now;
         }
     }
@@ -1263,55 +1396,70 @@ void eraserUpdate(GLFWwindow* window) {
     if (currentTool != Tool::Eraser || uiHovered) return;
     double sx, sy;
     glfwGetCursorPos(window, &sx, &sy);
-    Eigen::Vector2f worldClick = screenToWorld(window, sx, sy);
-    updateEraserHoverOutlines(worldClick);
+    bool pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
 
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) != GLFW_PRESS) return;
+    // Every command makes the simulation thread publish a new snapshot, so
+    // post only when something changed: the cursor moved, or the button is
+    // down (the countdown needs a post per frame) or was just let go
+    bool moved = sx != eraserCursorX || sy != eraserCursorY;
+    bool released = eraserWasPressed && !pressed;
+    eraserWasPressed = pressed;
+    if (!moved && !pressed && !released) return;
+    eraserCursorX = sx;
+    eraserCursorY = sy;
+    Vec2 worldClick = screenToWorld(window, sx, sy);
 
-    std::shared_ptr<Polygon> clickedPolygon = nullptr;
+    // Hit testing and erasing act on polygons, so they run on the
+    // simulation thread
+    sim.post([=] {
+        updateEraserHoverOutlines(worldClick);
 
-    for (auto& poly : polygons) {
-        if (poly->containsPoint(worldClick, 0.05f)) {
-            clickedPolygon = poly;
-            break;
-        }
-    }
+        if (!pressed) return;
 
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        if (clickedPolygon) {
-            // Track countdown
-            if (eraserCountdowns.find(clickedPolygon) == eraserCountdowns.end()) {
-                eraserCountdowns[clickedPolygon] = 1;
-            }
-            else {
-                eraserCountdowns[clickedPolygon]++;
-            }
+        std::shared_ptr<Polygon> clickedPolygon = nullptr;
 
-            if (eraserCountdowns[clickedPolygon] >= eraserDelayFrames) {
-                bool isSelected = std::find(selectedPolygons.begin(), selectedPolygons.end(), clickedPolygon) != selectedPolygons.end();
+        for (auto& poly : polygons) {
+            if (poly->containsPoint(worldClick, 0.05f)) {
+                clickedPolygon = poly;
+                break;
+            }
+        }
 
-                if (isSelected) {
-                    for (const auto& poly : selectedPolygons) {
-                        polygons.erase(std::remove(polygons.begin(), polygons.end(), poly), polygons.end());
-                    }
-                    selectedPolygons.clear();
+        if (pressed) {
+            if (clickedPolygon) {
+                // Track countdown
+                if (eraserCountdowns.find(clickedPolygon) == eraserCountdowns.end()) {
+                    eraserCountdowns[clickedPolygon] = 1;
                 }
                 else {
-                    polygons.erase(std::remove(polygons.begin(), polygons.end(), clickedPolygon), polygons.end());
-                    clearSelection();
+                    eraserCountdowns[clickedPolygon]++;
                 }
 
-                eraserCountdowns.clear(); // Reset all after a deletion
+                if (eraserCountdowns[clickedPolygon] >= eraserDelayFrames) {
+                    bool isSelected = std::find(selectedPolygons.begin(), selectedPolygons.end(), clickedPolygon) != selectedPolygons.end();
+
+                    if (isSelected) {
+                        for (const auto& poly : selectedPolygons) {
+                            removePolygon(poly);
+                        }
+                        selectedPolygons.clear();
+                    }
+                    else {
+                        removePolygon(clickedPolygon);
+                        clearSelection();
+                    }
+
+                    eraserCountdowns.clear(); // Reset all after a deletion
+                }
+            }
+            else {
+                eraserCountdowns.clear(); // Reset if not hovering any polygon
             }
         }
         else {
-            eraserCountdowns.clear(); // Reset if not hovering any polygon
+            eraserCountdowns.clear(); // Reset if mouse is not pressed
         }
-    }
-    else {
-        eraserCountdowns.clear(); // Reset if mouse is not pressed
-    }
-
+    });
 }
 
 void updateUIHover(GLFWwindow* window) {
@@ -1331,6 +1479,22 @@ void updateUIHover(GLFWwindow* window) {
 }
 
 
+// Shows the solver settings the governor chose in the title bar
+void showQuality(GLFWwindow* window) {
+    static int frame = 0;
+    if (++frame % 30 != 0) return;
+
+    const RenderSnapshot& snapshot = sim.latest();
+    std::string title = "Polygon Playground - " + std::to_string(snapshot.numPolygons) + " polygons ("
+        + std::to_string(snapshot.numSleeping) + " asleep), " + QualityGovernor::describe(snapshot.quality);
+    if (snapshot.deterministic) {
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(snapshot.hash));
+        title += ", deterministic, step " + std::to_string(snapshot.step) + " hash " + hash;
+    }
+    glfwSetWindowTitle(window, title.c_str());
+}
+
 int main() {
     if (!glfwInit()) {
         cerr << "Failed to initialize GLFW" << endl;
@@ -1375,6 +1539,7 @@ int main() {
     glfwSetCursorPosCallback(window, cursor_position_callback);
     glfwSetScrollCallback(window, scroll_callback);
 
+    sim.start();
 
     while (!glfwWindowShouldClose(window)) {
         updateUIHover(window);
@@ -1385,10 +1550,13 @@ int main() {
         glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
 
         display(window);
+        showQuality(window);
+
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    sim.stop();
 
     glfwDestroyWindow(window);
     glfwTerminate();
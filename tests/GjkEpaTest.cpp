@@ -0,0 +1,131 @@
+// GJK/EPA must hand the collision response the same axis and depth that
+// SAT does for a pair in contact. Pairs are placed just inside touching
+// distance, as contacts are found; at deep overlaps the two differ by
+// design (SAT's depth is the length of the projections' overlap, EPA's
+// the distance to push them apart). Returns nonzero if any pair disagrees.
+
+#include "GjkEpa.h"
+#include "SatKernels.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace std;
+
+struct TestPolygon {
+    vector<Vec2> x;
+    vector<Real> nx, ny;  // unit edge normals
+};
+
+// Corners of a regular polygon stretched to width x height, as the pencil
+// builds them, with the edge normals SAT takes as axes
+static TestPolygon makePolygon(const Vec2& center, int n, Real width, Real height, Real rotation) {
+    TestPolygon p;
+    for (int i = 0; i < n; ++i) {
+        Real angle = 2.0 * M_PI * i / n + rotation;
+        p.x.push_back(center + Vec2(0.5 * width * cos(angle), 0.5 * height * sin(angle)));
+    }
+    for (int i = 0; i < n; ++i) {
+        Vec2 e = p.x[(i + 1) % n] - p.x[i];
+        Vec2 normal = Vec2(e.y(), -e.x()).normalized();
+        p.nx.push_back(normal.x());
+        p.ny.push_back(normal.y());
+    }
+    return p;
+}
+
+int main() {
+#ifdef SIM_FLOAT
+    // EPA stops once a step gains less than sqrt(epsilon), about 3e-4
+    const Real depthTolerance = 5e-4;
+#else
+    const Real depthTolerance = 1e-9;
+#endif
+    const Real axisTolerance = 1e-4;
+
+    mt19937 rng(12345);
+    uniform_int_distribution<int> sides(3, 32);
+    uniform_real_distribution<Real> size(0.2, 1.0);
+    uniform_real_distribution<Real> angle(0.0, 2.0 * M_PI);
+    uniform_real_distribution<Real> unit(0.0, 1.0);
+
+    int overlapping = 0, failures = 0;
+    for (int trial = 0; trial < 2000; ++trial) {
+        int na = sides(rng), nb = sides(rng);
+        Real widthA = size(rng), heightA = size(rng), widthB = size(rng), heightB = size(rng);
+        TestPolygon a = makePolygon(Vec2::Zero(), na, widthA, heightA, angle(rng));
+        Real direction = angle(rng), rotationB = angle(rng);
+        Vec2 along(cos(direction), sin(direction));
+
+        // Distance along direction at which b just stops overlapping a
+        auto overlaps = [&](Real distance) {
+            TestPolygon b = makePolygon(distance * along, nb, widthB, heightB, rotationB);
+            int bestA, bestB;
+            Real depthA, depthB;
+            return satPair(a.x.data(), na, a.nx.data(), a.ny.data(), b.x.data(), nb, b.nx.data(), b.ny.data(),
+                bestA, depthA, bestB, depthB);
+        };
+        Real inside = 0.0, outside = 2.0;
+        for (int k = 0; k < 40; ++k) {
+            Real mid = 0.5 * (inside + outside);
+            (overlaps(mid) ? inside : outside) = mid;
+        }
+        Real smallest = std::min(std::min(widthA, heightA), std::min(widthB, heightB));
+        TestPolygon b = makePolygon((inside - 0.05 * smallest * unit(rng)) * along, nb, widthB, heightB, rotationB);
+
+        int bestA, bestB;
+        Real depthA, depthB;
+        bool satOverlap = satPair(a.x.data(), na, a.nx.data(), a.ny.data(), b.x.data(), nb, b.nx.data(), b.ny.data(),
+            bestA, depthA, bestB, depthB);
+
+        Vec2 normal;
+        Real depth;
+        GjkResult gjk = gjkEpa(a.x.data(), na, b.x.data(), nb, 0.0, normal, depth);
+
+        // Grazing pairs may come out either way
+        Real satDepth = satOverlap ? std::min(depthA, depthB) : 0.0;
+        if (satDepth < 1e-6 && gjk != GjkResult::Overlapping) continue;
+        if (satOverlap != (gjk == GjkResult::Overlapping)) {
+            if (satDepth >= 1e-6 || depth >= 1e-6) {
+                printf("pair %d (%d + %d sides): SAT says %s, GJK says %s\n", trial, na, nb,
+                    satOverlap ? "overlapping" : "apart", gjk == GjkResult::Overlapping ? "overlapping" : "apart");
+                ++failures;
+            }
+            continue;
+        }
+        if (!satOverlap) continue;
+        ++overlapping;
+
+        if (std::abs(depth - satDepth) > depthTolerance) {
+            printf("pair %d (%d + %d sides): depth %.9g from EPA, %.9g from SAT\n", trial, na, nb,
+                (double)depth, (double)satDepth);
+            ++failures;
+            continue;
+        }
+
+        // Where both polygons have an axis of (nearly) the least depth,
+        // either is a right answer
+        bool matches = false;
+        auto check = [&](const TestPolygon& p, int best, Real bestDepth) {
+            if (bestDepth - satDepth > depthTolerance) return;
+            Vec2 axis(p.nx[best], p.ny[best]);
+            matches = matches || std::abs(std::abs(axis.dot(normal)) - 1.0) < axisTolerance;
+        };
+        check(a, bestA, depthA);
+        check(b, bestB, depthB);
+        if (!matches) {
+            printf("pair %d (%d + %d sides): EPA normal (%.6f, %.6f) is not SAT's axis\n", trial, na, nb,
+                (double)normal.x(), (double)normal.y());
+            ++failures;
+        }
+    }
+
+    printf("%d overlapping pairs compared, %d disagreements\n", overlapping, failures);
+    return failures == 0 ? 0 : 1;
+}